@@ -0,0 +1,25 @@
+#if !defined(BlobView_h)
+#define BlobView_h
+
+#include <cstddef>
+
+namespace cce::tf {
+  //Non-owning view of a serialized data product. The memory belongs to the
+  // serializer which produced it and stays valid until that serializer is used again.
+  class BlobView {
+  public:
+    BlobView(): data_{nullptr}, size_{0} {}
+    BlobView(char const* iData, std::size_t iSize): data_{iData}, size_{iSize} {}
+
+    char const* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    char const* begin() const { return data_; }
+    char const* end() const { return data_+size_; }
+  private:
+    char const* data_;
+    std::size_t size_;
+  };
+}
+#endif
@@ -0,0 +1,82 @@
+#if !defined(BufferPool_h)
+#define BufferPool_h
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#include "tbb/concurrent_queue.h"
+
+namespace cce::tf {
+  //Recycles the memory of the std::vectors used to hold event data so that each event
+  // does not need new allocations. Returned buffers are kept in free lists based on their
+  // capacity rounded down to a power of 2. The pool can be used concurrently.
+  template<typename T>
+  class BufferPool {
+  public:
+    BufferPool(): allocations_{0}, reuses_{0} {}
+    BufferPool(BufferPool const&) = delete;
+    BufferPool& operator=(BufferPool const&) = delete;
+
+    //returns an empty vector able to hold at least iCapacity elements without reallocating
+    std::vector<T> get(std::size_t iCapacity) {
+      auto sizeClass = sizeClassForRequest(iCapacity);
+      std::vector<T> buffer;
+      if(sizeClass < kNSizeClasses) {
+        if(freeLists_[sizeClass].try_pop(buffer)) {
+          ++reuses_;
+          return buffer;
+        }
+        //round up so the buffer goes back to the same free list
+        iCapacity = std::size_t(1) << sizeClass;
+      }
+      ++allocations_;
+      buffer.reserve(iCapacity);
+      return buffer;
+    }
+
+    //a vector of any origin can be given back
+    void giveBack(std::vector<T>&& iBuffer) {
+      std::vector<T> buffer(std::move(iBuffer));
+      auto sizeClass = sizeClassForCapacity(buffer.capacity());
+      if(sizeClass < kNSizeClasses) {
+        buffer.clear();
+        freeLists_[sizeClass].push(std::move(buffer));
+      }
+    }
+
+    unsigned long long allocations() const { return allocations_.load(); }
+    unsigned long long reuses() const { return reuses_.load(); }
+
+  private:
+    //smaller buffers are cheaper to allocate than to pool
+    static constexpr unsigned int kMinSizeClass = 6;
+    static constexpr unsigned int kNSizeClasses = 8*sizeof(std::size_t);
+
+    static unsigned int floorLog2(std::size_t iValue) {
+      unsigned int l = 0;
+      while(iValue >>= 1) {
+        ++l;
+      }
+      return l;
+    }
+    static unsigned int sizeClassForRequest(std::size_t iCapacity) {
+      if(iCapacity <= (std::size_t(1) << kMinSizeClass)) {
+        return kMinSizeClass;
+      }
+      return floorLog2(iCapacity-1)+1;
+    }
+    static unsigned int sizeClassForCapacity(std::size_t iCapacity) {
+      if(iCapacity < (std::size_t(1) << kMinSizeClass)) {
+        return kNSizeClasses;
+      }
+      return floorLog2(iCapacity);
+    }
+
+    std::array<tbb::concurrent_queue<std::vector<T>>, kNSizeClasses> freeLists_;
+    std::atomic<unsigned long long> allocations_;
+    std::atomic<unsigned long long> reuses_;
+  };
+}
+#endif
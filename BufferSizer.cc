@@ -0,0 +1,29 @@
+#include "BufferSizer.h"
+
+#include <unordered_map>
+#include <string>
+#include <mutex>
+
+using namespace cce::tf;
+
+namespace {
+  struct Registry {
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<BufferSizeStatistics>> statistics_;
+  };
+
+  Registry& registry() {
+    static Registry s_registry;
+    return s_registry;
+  }
+}
+
+std::shared_ptr<BufferSizeStatistics> BufferSizeStatistics::forProduct(std::string_view iName) {
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.mutex_);
+  auto& found = r.statistics_[std::string(iName)];
+  if(not found) {
+    found = std::make_shared<BufferSizeStatistics>();
+  }
+  return found;
+}
@@ -0,0 +1,72 @@
+#if !defined(BufferSizer_h)
+#define BufferSizer_h
+
+#include <atomic>
+#include <memory>
+#include <string_view>
+#include <algorithm>
+#include <cstddef>
+#include "TBufferFile.h"
+
+namespace cce::tf {
+  //Running size statistics of one data product, shared by the serializers of all lanes.
+  // The expected size is an exponentially decaying maximum of the serialized sizes so it
+  // follows a growing data product at once but forgets a rare large one slowly.
+  class BufferSizeStatistics {
+  public:
+    //the same object is returned for the same data product name
+    static std::shared_ptr<BufferSizeStatistics> forProduct(std::string_view iName);
+
+    void add(std::size_t iSize) {
+      //concurrent lanes may lose an update which only makes the next pre-sizing less exact
+      auto expected = expectedSize_.load(std::memory_order_relaxed);
+      expectedSize_.store(std::max(iSize, expected - expected/kDecay), std::memory_order_relaxed);
+    }
+    std::size_t expectedSize() const { return expectedSize_.load(std::memory_order_relaxed); }
+
+  private:
+    static constexpr std::size_t kDecay = 16;
+    std::atomic<std::size_t> expectedSize_{0};
+  };
+
+  //Pre-sizes the TBufferFile of one serializer from the statistics of its data product and
+  // counts how often the buffer still had to grow while an object was streamed into it.
+  class BufferSizer {
+  public:
+    //statistics only used by this sizer
+    BufferSizer(): statistics_{std::make_shared<BufferSizeStatistics>()} {}
+    explicit BufferSizer(std::shared_ptr<BufferSizeStatistics> iStatistics): statistics_{std::move(iStatistics)} {}
+
+    //call after iBuffer.Reset() and before streaming into it
+    void presize(TBufferFile& iBuffer) {
+      auto expected = statistics_->expectedSize();
+      //headroom so a slowly growing data product does not have to grow the buffer every event
+      Int_t wanted = expected + expected/8;
+      if(wanted > iBuffer.BufferSize()) {
+        //the buffer is empty so nothing needs to be copied
+        iBuffer.Expand(wanted, kFALSE);
+        ++presizes_;
+      }
+      sizeBeforeStreaming_ = iBuffer.BufferSize();
+    }
+    //call after streaming into iBuffer
+    void update(TBufferFile const& iBuffer) {
+      if(iBuffer.BufferSize() != sizeBeforeStreaming_) {
+        ++reallocations_;
+      }
+      statistics_->add(iBuffer.Length());
+    }
+
+    //number of objects for which the buffer grew while streaming
+    unsigned long long reallocations() const { return reallocations_; }
+    //number of times the buffer was enlarged before streaming
+    unsigned long long presizes() const { return presizes_; }
+
+  private:
+    std::shared_ptr<BufferSizeStatistics> statistics_;
+    Int_t sizeBeforeStreaming_ = 0;
+    unsigned long long reallocations_ = 0;
+    unsigned long long presizes_ = 0;
+  };
+}
+#endif
@@ -15,28 +15,30 @@ class DeserializeProxyBase {
 
  virtual ~DeserializeProxyBase();
 
-  virtual int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const = 0;
-  virtual int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const = 0;
+  //concurrent calls must use different iLane values
+  virtual int deserialize(unsigned int iLane, std::vector<char> const& iBuffer, void* iWriteTo) const = 0;
+  virtual int deserialize(unsigned int iLane, char const * iBuffer, size_t iBufferSize, void* iWriteTo) const = 0;
 };
 
 
 template<typename D>
 class DeserializeProxy final : public DeserializeProxyBase {
  public:
- DeserializeProxy(TClass* tClass):
-  deserializer_{tClass} {}
+ DeserializeProxy(TClass* tClass, unsigned int iNLanes):
+  deserializer_{tClass, iNLanes} {}
 
-  int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
-    return deserializer_.deserialize(iBuffer, iWriteTo);
+  int deserialize(unsigned int iLane, std::vector<char> const& iBuffer, void* iWriteTo) const {
+    return deserializer_.deserialize(iLane, iBuffer, iWriteTo);
   }
-  int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const {
-    return deserializer_.deserialize(iBuffer, iBufferSize, iWriteTo);
+  int deserialize(unsigned int iLane, char const * iBuffer, size_t iBufferSize, void* iWriteTo) const {
+    return deserializer_.deserialize(iLane, iBuffer, iBufferSize, iWriteTo);
   }
  private:
   D deserializer_;
 };
 
-using DeserializeStrategy = ProxyVector<DeserializeProxyBase, TClass*>;
+//the deserializers are made for the given number of lanes and are shared by those lanes
+using DeserializeStrategy = ProxyVector<DeserializeProxyBase, TClass*, unsigned int>;
 
 }
 #endif
@@ -8,12 +8,13 @@
 namespace cce::tf {
 class Deserializer {
 public:
-  explicit Deserializer(TClass* iClass) : class_{iClass} {}
+  //keeps no state between calls so it can be used by any number of lanes
+  explicit Deserializer(TClass* iClass, unsigned int iNLanes=1) : class_{iClass} {}
 
-  int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
-    return deserialize(&iBuffer.front(), iBuffer.size(), iWriteTo);
+  int deserialize(unsigned int iLane, std::vector<char> const& iBuffer, void* iWriteTo) const {
+    return deserialize(iLane, &iBuffer.front(), iBuffer.size(), iWriteTo);
   }
-  int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const{
+  int deserialize(unsigned int iLane, char const * iBuffer, size_t iBufferSize, void* iWriteTo) const{
     TBufferFile bufferFile{TBuffer::kRead};
 
     bufferFile.SetBuffer( const_cast<char*>(iBuffer), iBufferSize, kFALSE);
@@ -24,6 +24,12 @@ template <typename F>
 std::unique_ptr<FunctorTask<F>>  make_functor_task(F f) {
   return std::make_unique<FunctorTask<F>>(std::move(f));
 }
+
+//the task's memory comes from iArena
+template <typename F>
+std::unique_ptr<FunctorTask<F>>  make_functor_task(TaskArena& iArena, F f) {
+  return std::unique_ptr<FunctorTask<F>>(new (iArena) FunctorTask<F>(std::move(f)));
+}
 }
 #endif
 
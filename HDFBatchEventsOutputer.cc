@@ -8,6 +8,7 @@
 #include <memory>
 #include <iostream>
 #include <cstring>
+#include <stdexcept>
 #include <cmath>
 #include <set>
 
@@ -82,7 +83,11 @@ void HDFBatchEventsOutputer::setupForLane(unsigned int iLaneIndex, std::vector<D
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case pds::Serialization::kRootUnrolled:
     {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+  case pds::Serialization::kRaw:
+    //rejected by the maker
+    throw std::runtime_error("HDF files can not use Raw serialization");
   }
+  prebuildWriteActionSequences(serialization_, iDPs);
   s.reserve(iDPs.size());
   for(auto const& dp: iDPs) {
     s.emplace_back(dp.name(), dp.classType());
@@ -153,6 +158,7 @@ void HDFBatchEventsOutputer::printSummary() const  {
 
   std::cout <<"HDFBatchEventsOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
     "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+  std::cout <<"  buffer pool allocations: "<<bufferPool_.allocations()<<" reuses: "<<bufferPool_.reuses()<<"\n";
   std::cout << "  end of job file write time: "<<writeTime.count()<<"us\n";
 
   summarize_serializers(serializers_);
@@ -190,13 +196,14 @@ void HDFBatchEventsOutputer::finishBatchAsync(unsigned int iBatchIndex, TaskHold
     std::copy(blob.begin(), blob.end(), std::back_inserter(batchBlob));
 
     //release memory
-    blob = {};
+    bufferPool_.giveBack(std::move(blob));
   }
 
   std::vector<char> bufferToWrite;
   if(compressionChoice_ == CompressionChoice::kBatch or compressionChoice_ == CompressionChoice::kBoth) {
-    bufferToWrite  = pds::compressBuffer(0,0, compression_, compressionLevel_, batchBlob);
-    batchBlob = std::vector<char>();
+    bufferToWrite = bufferPool_.get(batchBlob.size()+batchBlob.size()/128+64);
+    pds::compressBuffer(0,0, compression_, compressionLevel_, batchBlob, bufferToWrite);
+    bufferPool_.giveBack(std::move(batchBlob));
   } else {
     bufferToWrite = std::move(batchBlob);
   }
@@ -237,6 +244,7 @@ HDFBatchEventsOutputer::output(std::vector<EventIdentifier> iEventIDs,
   //std::cout <<"wrote ids"<<std::endl;
   write_ds<char>(group_, PRODUCTS_DSNAME, iBuffer);
   write_ds<uint32_t>(group_, OFFSETS_DSNAME, iOffsets); 
+  bufferPool_.giveBack(std::move(iBuffer));
 }
 
 void 
@@ -283,7 +291,8 @@ std::pair<std::vector<uint32_t>, std::vector<char>> HDFBatchEventsOutputer::writ
   offsets.push_back(bufferSize);
 
   //initialize with 0
-  std::vector<char> buffer(bufferSize, 0);
+  std::vector<char> buffer = bufferPool_.get(bufferSize);
+  buffer.resize(bufferSize, 0);
   
   {
     uint32_t index = 0;
@@ -295,7 +304,9 @@ std::pair<std::vector<uint32_t>, std::vector<char>> HDFBatchEventsOutputer::writ
   }
 
   if(compressionChoice_ == CompressionChoice::kEvents or compressionChoice_ == CompressionChoice::kBoth) {
-    auto cBuffer  = pds::compressBuffer(0,0, compression_, compressionLevel_, buffer);
+    std::vector<char> cBuffer = bufferPool_.get(buffer.size()+buffer.size()/128+64);
+    pds::compressBuffer(0,0, compression_, compressionLevel_, buffer, cBuffer);
+    bufferPool_.giveBack(std::move(buffer));
 
     return {std::move(offsets), std::move(cBuffer)};
   }
@@ -328,6 +339,11 @@ namespace {
         std::cout <<"unknown serialization "<<serializationName<<std::endl;
         return {};
       }
+      if(*serialization == pds::Serialization::kRaw) {
+        //the HDF files have no place to record the layout fingerprint
+        std::cout <<"Raw serialization is not supported by "<<"HDFBatchEventsOutputer"<<std::endl;
+        return {};
+      }
       auto compressionChoiceName = params.get<std::string>("compressionChoice", "Events");
       auto compressionChoice = HDFBatchEventsOutputer::CompressionChoice::kEvents;
       if(compressionChoiceName == "Events") {
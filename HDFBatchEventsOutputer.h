@@ -13,6 +13,7 @@
 #include "SerializeStrategy.h"
 #include "DataProductRetriever.h"
 #include "pds_writer.h"
+#include "BufferPool.h"
 
 #include "SerialTaskQueue.h"
 
@@ -70,6 +71,7 @@ private:
   int compressionLevel_;
   CompressionChoice compressionChoice_;
   pds::Serialization serialization_;
+  mutable BufferPool<char> bufferPool_;
   mutable std::chrono::microseconds serialTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
   };    
@@ -8,6 +8,7 @@
 #include <memory>
 #include <iostream>
 #include <cstring>
+#include <stdexcept>
 #include <cmath>
 #include <set>
 
@@ -64,7 +65,11 @@ void HDFEventOutputer::setupForLane(unsigned int iLaneIndex, std::vector<DataPro
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case pds::Serialization::kRootUnrolled:
     {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+  case pds::Serialization::kRaw:
+    //rejected by the maker
+    throw std::runtime_error("HDF files can not use Raw serialization");
   }
+  prebuildWriteActionSequences(serialization_, iDPs);
   s.reserve(iDPs.size());
   offsetsAndBlob_.first.resize(iDPs.size()+1, 0);
   for(auto const& dp: iDPs) {
@@ -97,6 +102,7 @@ void HDFEventOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier cons
 void HDFEventOutputer::printSummary() const  {
   std::cout <<"HDFEventOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
     "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+  std::cout <<"  buffer pool allocations: "<<bufferPool_.allocations()<<" reuses: "<<bufferPool_.reuses()<<"\n";
   summarize_serializers(serializers_);
 }
 
@@ -122,6 +128,7 @@ HDFEventOutputer::output(EventIdentifier const& iEventID,
   write_ds<unsigned long long>(group_, EVENTS_DSNAME, ids);
   write_ds<char>(group_, PRODUCTS_DSNAME, iBuffer);
   write_ds<uint32_t>(group_, OFFSETS_DSNAME, iOffsets); 
+  bufferPool_.giveBack(std::move(iBuffer));
 }
 
 void 
@@ -167,7 +174,8 @@ std::pair<std::vector<uint32_t>, std::vector<char>> HDFEventOutputer::writeDataP
   offsets.push_back(bufferSize);
 
   //initialize with 0
-  std::vector<char> buffer(bufferSize, 0);
+  std::vector<char> buffer = bufferPool_.get(bufferSize);
+  buffer.resize(bufferSize, 0);
   
   {
     uint32_t index = 0;
@@ -178,9 +186,11 @@ std::pair<std::vector<uint32_t>, std::vector<char>> HDFEventOutputer::writeDataP
     assert(buffer.size() == offsets[index]);
   }
 
-  auto cBuffer  = pds::compressBuffer(0,0, compression_, compressionLevel_, buffer);
+  std::vector<char> cBuffer = bufferPool_.get(buffer.size()+buffer.size()/128+64);
+  pds::compressBuffer(0,0, compression_, compressionLevel_, buffer, cBuffer);
+  bufferPool_.giveBack(std::move(buffer));
 
-  return {offsets, cBuffer};
+  return {std::move(offsets), std::move(cBuffer)};
 }
 namespace {
   class HDFEventMaker : public OutputerMakerBase {
@@ -208,6 +218,11 @@ namespace {
         std::cout <<"unknown serialization "<<serializationName<<std::endl;
         return {};
       }
+      if(*serialization == pds::Serialization::kRaw) {
+        //the HDF files have no place to record the layout fingerprint
+        std::cout <<"Raw serialization is not supported by "<<"HDFEventOutputer"<<std::endl;
+        return {};
+      }
 
       return std::make_unique<HDFEventOutputer>(*fileName, iNLanes, chunkSize, *compression, compressionLevel, *serialization);
     }
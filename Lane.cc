@@ -7,7 +7,7 @@
 
 using namespace cce::tf;
 
-Lane::Lane(unsigned int iIndex, SharedSourceBase* iSource, double iScaleFactor): source_(iSource), index_{iIndex} {
+Lane::Lane(unsigned int iIndex, SharedSourceBase* iSource, double iScaleFactor): source_(iSource), taskArena_{std::make_unique<TaskArena>()}, index_{iIndex} {
     if(iScaleFactor >=0.) {
       waiters_.reserve(source_->numberOfDataProducts());
       for( int ib = 0; ib< source_->numberOfDataProducts(); ++ib) {
@@ -27,7 +27,7 @@ TaskHolder Lane::makeWaiterTask(tbb::task_group& group, size_t index, TaskHolder
     return holder;
   } else {  
     return TaskHolder(group,
-                      make_functor_task([index,  holder, this]() {
+                      make_functor_task(*taskArena_, [index,  holder, this]() {
                           auto laneIndex = this->index_;
                           auto& w = waiters_[index];
                           w.waitAsync(dataProducts(),std::move(holder));
@@ -39,7 +39,7 @@ TaskHolder Lane::makeTaskForDataProduct(tbb::task_group& group, size_t index, Da
   if(outputer.usesProductReadyAsync()) {
     auto laneIndex = this->index_;
     return makeWaiterTask(group, index,TaskHolder(group, 
-                                                  make_functor_task([holder, laneIndex, &iDP, &outputer]() {
+                                                  make_functor_task(*taskArena_, [holder, laneIndex, &iDP, &outputer]() {
                                                       outputer.productReadyAsync(laneIndex, iDP, std::move(holder));
                                                     })));
   } else {
@@ -52,7 +52,7 @@ void Lane::processEventAsync(tbb::task_group& group, TaskHolder iCallback, const
   
   //std::cout <<"make process event task"<<std::endl;
   TaskHolder holder(group, 
-                    make_functor_task([&outputer, this, callback=std::move(iCallback)]() {
+                    make_functor_task(*taskArena_, [&outputer, this, callback=std::move(iCallback)]() {
                         outputer.outputAsync(this->index_, source_->eventIdentifier(index_, presentEventIndex_),
                                              std::move(callback));
                       }));
@@ -66,16 +66,38 @@ void Lane::processEventAsync(tbb::task_group& group, TaskHolder iCallback, const
   }
 }
 
+long Lane::nextEventIndex(std::atomic<long>& index) {
+  if(claimSize_ == 1) {
+    return index++;
+  }
+  //claiming a block keeps the lanes from contending on index for every event
+  if(nextClaimedIndex_ == endOfClaim_) {
+    nextClaimedIndex_ = index.fetch_add(claimSize_);
+    endOfClaim_ = nextClaimedIndex_+claimSize_;
+  }
+  return nextClaimedIndex_++;
+}
+
 void Lane::doNextEvent(std::atomic<long>& index, tbb::task_group& group,  const OutputerBase& outputer, AtomicRefCounter counter) {
   using namespace std::string_literals;
-  presentEventIndex_ = index++;
+  //indices already claimed must still be processed
+  if(controller_ and nextClaimedIndex_ == endOfClaim_) {
+    auto nEvents = nEventsProcessed_ - nEventsReported_;
+    nEventsReported_ = nEventsProcessed_;
+    if(not controller_->continueLane(index_, nEvents)) {
+      return;
+    }
+  }
+  presentEventIndex_ = nextEventIndex(index);
   if(source_->mayBeAbleToGoToEvent(presentEventIndex_)) {
+    taskArena_->startEvent();
     if(verbose_) {
       std::cout <<"event "+std::to_string(presentEventIndex_)+"\n"<<std::flush;
     }
     
-    OptionalTaskHolder processEventTask(group, make_functor_task([this,&index, &group, &outputer, counter]() {
-          TaskHolder recursiveTask(group, make_functor_task([this, &index, &group, &outputer, counter]() {
+    OptionalTaskHolder processEventTask(group, make_functor_task(*taskArena_, [this,&index, &group, &outputer, counter]() {
+          ++nEventsProcessed_;
+          TaskHolder recursiveTask(group, make_functor_task(*taskArena_, [this, &index, &group, &outputer, counter]() {
                 doNextEvent(index, group, outputer, std::move(counter));
               }));
           processEventAsync(group, std::move(recursiveTask), outputer);
@@ -11,6 +11,8 @@
 #include "OutputerBase.h"
 #include "Waiter.h"
 #include "AtomicRefCounter.h"
+#include "TaskArena.h"
+#include "LaneController.h"
 
 namespace cce::tf {
 class Lane {
@@ -20,10 +22,17 @@ public:
   void processEventsAsync(std::atomic<long>& index, tbb::task_group& group, const OutputerBase& outputer, AtomicRefCounter);
 
   void setVerbose(bool iSet) { verbose_ = iSet; }
+  //the number of consecutive event indices taken from the shared index at a time
+  void setClaimSize(unsigned int iSize) { claimSize_ = iSize; }
+  //if set, the Lane stops processing when the controller says so
+  void setController(LaneController* iController) { controller_ = iController; }
 
   std::vector<DataProductRetriever> const& dataProducts() const { return source_->dataProducts(index_, presentEventIndex_); }
 
+  //the global index, the same whatever the claim size
   long presentEventIndex() const { return presentEventIndex_;}
+  unsigned long long nEventsProcessed() const { return nEventsProcessed_; }
+  TaskArena const& taskArena() const { return *taskArena_; }
 private:
 
   std::vector<DataProductRetriever>& mutableDataProducts() { return source_->dataProducts(index_, presentEventIndex_); }
@@ -33,13 +42,25 @@ private:
 
   void processEventAsync(tbb::task_group& group, TaskHolder iCallback, const OutputerBase& outputer);
 
+  long nextEventIndex(std::atomic<long>& index);
+
   void doNextEvent(std::atomic<long>& index, tbb::task_group& group,  const OutputerBase& outputer, 
 		   AtomicRefCounter counter);
 
   SharedSourceBase* source_;
   std::vector<Waiter> waiters_;
+  //held by pointer so the Lane can be moved while tasks refer to the arena
+  std::unique_ptr<TaskArena> taskArena_;
   long presentEventIndex_ = -1;
+  //the indices in [nextClaimedIndex_, endOfClaim_) belong to this lane
+  long nextClaimedIndex_ = 0;
+  long endOfClaim_ = 0;
+  unsigned long long nEventsProcessed_ = 0;
+  //the part of nEventsProcessed_ already given to controller_
+  unsigned long long nEventsReported_ = 0;
   unsigned int index_;
+  unsigned int claimSize_ = 1;
+  LaneController* controller_ = nullptr;
   bool verbose_ = false;
 };
 }
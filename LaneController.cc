@@ -0,0 +1,106 @@
+#include "LaneController.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "SerialTaskQueue.h"
+
+using namespace cce::tf;
+
+LaneController::LaneController(unsigned int iMaxLanes, unsigned int iStartLanes, std::function<void(unsigned int)> iRestart):
+  restart_{std::move(iRestart)},
+  states_{std::make_unique<std::atomic<LaneState>[]>(iMaxLanes)},
+  maxLanes_{iMaxLanes},
+  target_{std::clamp(iStartLanes, 1U, iMaxLanes)},
+  lastAdjustTime_{Clock::now()},
+  timeAtTarget_(iMaxLanes+1, Clock::duration::zero()) {
+  for(unsigned int i=0; i<maxLanes_; ++i) {
+    states_[i] = i < target_ ? kRunning : kStopped;
+  }
+  //start counting from now
+  SerialTaskQueue::takeMaxBusyTime();
+}
+
+bool LaneController::continueLane(unsigned int iLaneIndex, unsigned long long iNEvents) {
+  auto const previousNEvents = nEvents_.fetch_add(iNEvents);
+  auto const nEvents = previousNEvents+iNEvents;
+  //a Lane claiming blocks of events can add several at once
+  if(nEvents/kEventsPerCheck != previousNEvents/kEventsPerCheck) {
+    std::unique_lock<std::mutex> lock(adjustMutex_, std::try_to_lock);
+    if(lock.owns_lock()) {
+      auto now = Clock::now();
+      if(now - lastAdjustTime_ >= kInterval) {
+        adjust(now, nEvents);
+      }
+    }
+  }
+  if(iLaneIndex < target_.load()) {
+    return true;
+  }
+  states_[iLaneIndex] = kStopped;
+  //the target may have been raised after the check, in which case either this Lane continues or
+  // the restart already happened
+  if(iLaneIndex < target_.load()) {
+    auto expected = kStopped;
+    if(states_[iLaneIndex].compare_exchange_strong(expected, kRunning)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void LaneController::adjust(Clock::time_point iNow, unsigned long long iNEvents) {
+  auto const interval = iNow - lastAdjustTime_;
+  double const seconds = std::chrono::duration<double>(interval).count();
+  double const throughput = (iNEvents - lastNEvents_)/seconds;
+  double const occupancy = std::chrono::duration<double>(SerialTaskQueue::takeMaxBusyTime()).count()/seconds;
+
+  auto const target = target_.load();
+  timeAtTarget_[target] += interval;
+  lastAdjustTime_ = iNow;
+  lastNEvents_ = iNEvents;
+
+  int step = 0;
+  if(lastThroughput_ == 0.) {
+    //first measurement, explore upwards unless a queue is already the bottleneck
+    direction_ = occupancy > kSaturatedOccupancy ? -1 : 1;
+    step = direction_;
+  } else if(throughput > lastThroughput_*(1.+kSignificantChange)) {
+    step = direction_;
+  } else if(throughput < lastThroughput_*(1.-kSignificantChange)) {
+    direction_ = -direction_;
+    step = direction_;
+  } else if(occupancy > kSaturatedOccupancy) {
+    direction_ = -1;
+    step = direction_;
+  }
+  lastThroughput_ = throughput;
+
+  //larger steps when there are many Lanes so the search does not take too long
+  auto newTarget = static_cast<int>(target)+step*std::max(1, static_cast<int>(target)/8);
+  newTarget = std::clamp(newTarget, 1, static_cast<int>(maxLanes_));
+  if(newTarget != static_cast<int>(target)) {
+    ++nAdjustments_;
+    setTarget(newTarget);
+  }
+}
+
+void LaneController::setTarget(unsigned int iTarget) {
+  auto oldTarget = target_.exchange(iTarget);
+  for(unsigned int i = oldTarget; i < iTarget; ++i) {
+    auto expected = kStopped;
+    if(states_[i].compare_exchange_strong(expected, kRunning)) {
+      restart_(i);
+    }
+  }
+}
+
+void LaneController::finish() {
+  std::lock_guard<std::mutex> guard(adjustMutex_);
+  timeAtTarget_[target_.load()] += Clock::now() - lastAdjustTime_;
+  lastAdjustTime_ = Clock::now();
+}
+
+unsigned int LaneController::steadyStateLanes() const {
+  return std::max_element(timeAtTarget_.begin(), timeAtTarget_.end()) - timeAtTarget_.begin();
+}
@@ -0,0 +1,64 @@
+#if !defined(LaneController_h)
+#define LaneController_h
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <functional>
+
+namespace cce::tf {
+  //Chooses how many of the Lanes process events. Lanes with an index below the target keep
+  // going while the others stop once they finish their event. At regular intervals the event
+  // throughput is compared to that of the previous interval: the target keeps moving in the
+  // same direction while the throughput improves and reverses when it degrades. If it is
+  // unchanged the target only goes down, and only if a SerialTaskQueue was busy for most of the
+  // interval since additional Lanes then just wait on that queue.
+  class LaneController {
+  public:
+    //iRestart is called to start again a Lane which had stopped
+    LaneController(unsigned int iMaxLanes, unsigned int iStartLanes, std::function<void(unsigned int)> iRestart);
+
+    //called by a Lane before it claims its next events, iNEvents is the number of events the Lane
+    // processed since its previous call. Returns false if the Lane must stop.
+    bool continueLane(unsigned int iLaneIndex, unsigned long long iNEvents);
+
+    unsigned int targetLanes() const { return target_.load(); }
+    //must be called once the Lanes are done
+    void finish();
+    //the number of Lanes which was used for the longest time
+    unsigned int steadyStateLanes() const;
+    unsigned int nAdjustments() const { return nAdjustments_; }
+
+  private:
+    enum LaneState { kRunning, kStopped };
+    using Clock = std::chrono::steady_clock;
+
+    void adjust(Clock::time_point iNow, unsigned long long iNEvents);
+    void setTarget(unsigned int iTarget);
+
+    static constexpr unsigned int kEventsPerCheck = 16;
+    static constexpr std::chrono::milliseconds kInterval{100};
+    //a queue this busy limits the throughput
+    static constexpr double kSaturatedOccupancy = 0.9;
+    //smaller throughput changes are considered noise
+    static constexpr double kSignificantChange = 0.02;
+
+    std::function<void(unsigned int)> restart_;
+    std::unique_ptr<std::atomic<LaneState>[]> states_;
+    unsigned int const maxLanes_;
+    std::atomic<unsigned int> target_;
+    std::atomic<unsigned long long> nEvents_{0};
+
+    //only used while holding adjustMutex_
+    std::mutex adjustMutex_;
+    Clock::time_point lastAdjustTime_;
+    unsigned long long lastNEvents_ = 0;
+    double lastThroughput_ = 0.;
+    int direction_ = 1;
+    unsigned int nAdjustments_ = 0;
+    std::vector<Clock::duration> timeAtTarget_;
+  };
+}
+#endif
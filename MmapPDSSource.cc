@@ -0,0 +1,260 @@
+#include "MmapPDSSource.h"
+#include "SourceFactory.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <cassert>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TClass.h"
+
+using namespace cce::tf;
+
+MmapPDSSource::MmapPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName, unsigned long long iFirstEvent) :
+                 SharedSourceBase(iNEvents),
+  firstEvent_{iFirstEvent},
+  readTime_{std::chrono::microseconds::zero()}
+{
+  pds::Serialization serialization;
+  std::vector<char> dictionary;
+  uint32_t flags;
+  uint64_t layoutFingerprint;
+  std::vector<pds::ProductInfo> productInfo;
+  {
+    std::ifstream file{iName, std::ios_base::binary};
+    if(not file) {
+      throw std::runtime_error("unable to open file "+iName);
+    }
+    productInfo = readFileHeader(file, compression_, serialization, dictionary, flags, layoutFingerprint);
+    checkLayoutFingerprint(serialization, productInfo, layoutFingerprint);
+    dictionary_ = pds::makeDecompressionDictionary(dictionary);
+    perProductCompression_ = flags & pds::kFileHasPerProductCompression;
+    if(flags & pds::kFileHasProductReferences) {
+      referenceResolver_ = std::make_unique<pds::ProductReferenceResolver>(iName, compression_, dictionary_.get(), productInfo.size());
+    }
+    if(flags & pds::kFileHasColumnarBatches) {
+      throw std::runtime_error("MmapPDSSource can not read columnar batches, use SharedPDSSource");
+    }
+    presentOffset_ = file.tellg();
+  }
+
+  int fd = open(iName.c_str(), O_RDONLY);
+  if(fd < 0) {
+    throw std::runtime_error("unable to open file "+iName);
+  }
+  struct stat fileStat;
+  if(fstat(fd, &fileStat) != 0) {
+    close(fd);
+    throw std::runtime_error("unable to stat file "+iName);
+  }
+  fileSize_ = fileStat.st_size;
+  void* mapped = mmap(nullptr, fileSize_, PROT_READ, MAP_SHARED, fd, 0);
+  //the mapping stays valid after the descriptor is closed
+  close(fd);
+  if(mapped == MAP_FAILED) {
+    throw std::runtime_error("unable to memory map file "+iName);
+  }
+  //lanes read the records roughly in file order
+  madvise(mapped, fileSize_, MADV_SEQUENTIAL);
+  fileBegin_ = static_cast<char const*>(mapped);
+
+  eventIndex_ = pds::readEventIndex(fileBegin_, fileSize_);
+  if(eventIndex_.empty()) {
+    //without an index the only option is to walk the file
+    EventIdentifier id;
+    size_t recordSize;
+    for(unsigned long long i=0; i<firstEvent_ and nextEventRecord(id, recordSize); ++i) {}
+  }
+
+  deserializers_ = pds::makeDeserializeStrategy(serialization, productInfo, iNLanes);
+  laneInfos_.reserve(iNLanes);
+  for(unsigned int i = 0; i< iNLanes; ++i) {
+    laneInfos_.emplace_back(productInfo);
+  }
+}
+
+MmapPDSSource::~MmapPDSSource() {
+  if(fileBegin_) {
+    munmap(const_cast<char*>(fileBegin_), fileSize_);
+  }
+}
+
+MmapPDSSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo):
+  decompressTime_{std::chrono::microseconds::zero()},
+  deserializeTime_{std::chrono::microseconds::zero()}
+{
+  dataProducts_.reserve(productInfo.size());
+  dataBuffers_.resize(productInfo.size(), nullptr);
+  size_t index =0;
+  for(auto const& pi : productInfo) {
+    
+    TClass* cls = TClass::GetClass(pi.className().c_str());
+    assert(cls);
+    dataBuffers_[index] = cls->New();
+    dataProducts_.emplace_back(index,
+			       &dataBuffers_[index],
+                               pi.name(),
+                               cls,
+			       &delayedRetriever_);
+    ++index;
+  }
+}
+
+MmapPDSSource::LaneInfo::~LaneInfo() {
+  auto it = dataProducts_.begin();
+  for( void * b: dataBuffers_) {
+    it->classType()->Destructor(b);
+    ++it;
+  }
+}
+
+size_t MmapPDSSource::numberOfDataProducts() const {
+  return laneInfos_[0].dataProducts_.size();
+}
+
+std::vector<DataProductRetriever>& MmapPDSSource::dataProducts(unsigned int iLane, long iEventIndex) {
+  return laneInfos_[iLane].dataProducts_;
+}
+
+EventIdentifier MmapPDSSource::eventIdentifier(unsigned int iLane, long iEventIndex) {
+  return laneInfos_[iLane].eventID_;
+}
+
+uint32_t const* MmapPDSSource::nextEventRecord(EventIdentifier& oEventID, size_t& oRecordSize) {
+  //header structure in words
+  //constexpr size_t kTransitionTypeW=0;
+  constexpr size_t kEventIDMSW=3;
+  constexpr size_t kEventIDLSW=4;
+  constexpr size_t kRunIDW=1;
+  constexpr size_t kLumiIDW=2;
+
+  constexpr size_t kHeaderSizeInBytes = (pds::kEventHeaderSizeInWords+1)*4;
+  if(presentOffset_ + kHeaderSizeInBytes > fileSize_) {
+    return nullptr;
+  }
+  auto header = reinterpret_cast<uint32_t const*>(fileBegin_+presentOffset_);
+  if(header[0] == pds::kEventIndexRecordMarker) {
+    return nullptr;
+  }
+  uint32_t recordSize = header[pds::kEventHeaderSizeInWords];
+
+  //record is followed by a crosscheck word
+  if(presentOffset_ + kHeaderSizeInBytes + (recordSize+1)*4 > fileSize_) {
+    std::cout <<"MmapPDSSource: file ends in the middle of an event record"<<std::endl;
+    return nullptr;
+  }
+
+  unsigned long long eventIDTopWord = header[kEventIDMSW];
+  eventIDTopWord = eventIDTopWord <<32;
+  unsigned long long eventID = eventIDTopWord+header[kEventIDLSW];
+  oEventID = {header[kRunIDW], header[kLumiIDW], eventID};
+
+  auto record = header+pds::kEventHeaderSizeInWords+1;
+  assert(record[recordSize] == recordSize);
+
+  presentOffset_ += kHeaderSizeInBytes + (recordSize+1)*4;
+  oRecordSize = recordSize;
+  return record;
+}
+
+void MmapPDSSource::readEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder iTask) {
+  if(not eventIndex_.empty()) {
+    //any lane can go directly to its event
+    auto fileEventIndex = firstEvent_+iEventIndex;
+    if(fileEventIndex >= eventIndex_.size()) {
+      return;
+    }
+    auto const& entry = eventIndex_[fileEventIndex];
+    laneInfos_[iLane].eventID_ = entry.eventID;
+    auto record = reinterpret_cast<uint32_t const*>(fileBegin_+entry.offset) + pds::kEventHeaderSizeInWords+1;
+    assert(record[entry.recordSize] == entry.recordSize);
+    decompressAndDeserializeAsync(iLane, record, entry.recordSize, std::move(iTask));
+    return;
+  }
+  queue_.push(*iTask.group(), [iLane, optTask = std::move(iTask), this]() mutable {
+      auto start = std::chrono::high_resolution_clock::now();
+      size_t recordSize;
+      auto record = nextEventRecord(this->laneInfos_[iLane].eventID_, recordSize);
+      readTime_ +=std::chrono::duration_cast<decltype(readTime_)>(std::chrono::high_resolution_clock::now() - start);
+      if(record) {
+        decompressAndDeserializeAsync(iLane, record, recordSize, std::move(optTask));
+      }
+    });
+}
+
+void MmapPDSSource::decompressAndDeserializeAsync(unsigned int iLane, uint32_t const* record, size_t recordSize, OptionalTaskHolder iTask) {
+  auto group = iTask.group();
+  group->run([this, record, recordSize, task = iTask.releaseToTaskHolder(), iLane]() {
+      auto& laneInfo = this->laneInfos_[iLane];
+
+      if(pds::Compression::kNone == this->compression_ and not perProductCompression_) {
+        //nothing to decompress so can deserialize straight from the mapped file
+        auto start = std::chrono::high_resolution_clock::now();
+        pds::deserializeDataProducts(record+1, record+recordSize, laneInfo.dataProducts_, deserializers_, iLane);
+        laneInfo.deserializeTime_ += 
+          std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
+        return;
+      }
+      auto start = std::chrono::high_resolution_clock::now();
+      std::vector<uint32_t> uBuffer = perProductCompression_ ? pds::uncompressPerProductEventBuffer(this->compression_, record, recordSize, dictionary_.get(), referenceResolver_.get())
+        : pds::uncompressEventBuffer(this->compression_, record, recordSize, dictionary_.get());
+      laneInfo.decompressTime_ += 
+        std::chrono::duration_cast<decltype(laneInfo.decompressTime_)>(std::chrono::high_resolution_clock::now() - start);
+      
+      start = std::chrono::high_resolution_clock::now();
+      pds::deserializeDataProducts(uBuffer.begin(), uBuffer.end(), laneInfo.dataProducts_, deserializers_, iLane);
+      laneInfo.deserializeTime_ += 
+        std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
+    });
+}
+
+void MmapPDSSource::printSummary() const {
+  std::cout <<"\nSource:\n"
+    "   read time: "<<readTime().count()<<"us\n"
+    "   decompress time: "<<decompressTime().count()<<"us\n"
+    "   deserialize time: "<<deserializeTime().count()<<"us\n"<<std::endl;
+};
+
+std::chrono::microseconds MmapPDSSource::readTime() const {
+  return readTime_;
+}
+
+std::chrono::microseconds MmapPDSSource::decompressTime() const {
+  auto time = std::chrono::microseconds::zero();
+  for(auto const& l : laneInfos_) {
+    time += l.decompressTime_;
+  }
+  return time;
+}
+
+std::chrono::microseconds MmapPDSSource::deserializeTime() const {
+  auto time = std::chrono::microseconds::zero();
+  for(auto const& l : laneInfos_) {
+    time += l.deserializeTime_;
+  }
+  return time;
+}
+
+
+namespace {
+    class Maker : public SourceMakerBase {
+  public:
+    Maker(): SourceMakerBase("MmapPDSSource") {}
+      std::unique_ptr<SharedSourceBase> create(unsigned int iNLanes, unsigned long long iNEvents, ConfigurationParameters const& params) const final {
+        auto fileName = params.get<std::string>("fileName");
+        if(not fileName) {
+          std::cout <<"no file name given\n";
+          return {};
+        }
+        unsigned long long firstEvent = params.get<unsigned int>("firstEvent", 0);
+        return std::make_unique<MmapPDSSource>(iNLanes, iNEvents, *fileName, firstEvent);
+    }
+    };
+
+  Maker s_maker;
+}
@@ -0,0 +1,89 @@
+#if !defined(MmapPDSSource_h)
+#define MmapPDSSource_h
+
+#include <string>
+#include <memory>
+#include <chrono>
+#include <iostream>
+
+#include "SharedSourceBase.h"
+#include "DataProductRetriever.h"
+#include "DelayedProductRetriever.h"
+#include "SerialTaskQueue.h"
+#include "DeserializeStrategy.h"
+#include "pds_reading.h"
+
+
+namespace cce::tf {
+  class MmapPDSDelayedRetriever : public DelayedProductRetriever {
+    void getAsync(DataProductRetriever&, int index, TaskHolder) final {}
+  };
+  
+  //Reads a PDS file by memory mapping it. The serial part of reading an event is just
+  // finding where the next event record starts, which is not needed at all if the file has an
+  // event index. Decompression then reads directly from the mapped memory.
+  class MmapPDSSource : public SharedSourceBase {
+  public:
+    MmapPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName, unsigned long long iFirstEvent=0);
+    MmapPDSSource(MmapPDSSource&&) = delete;
+    MmapPDSSource(MmapPDSSource const&) = delete;
+    ~MmapPDSSource();
+
+  size_t numberOfDataProducts() const final;
+  std::vector<DataProductRetriever>& dataProducts(unsigned int iLane, long iEventIndex) final;
+  EventIdentifier eventIdentifier(unsigned int iLane, long iEventIndex) final;
+
+  void printSummary() const final;
+  private:
+  
+  void readEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder) final;
+
+  //returns nullptr if no more events in the file
+  uint32_t const* nextEventRecord(EventIdentifier&, size_t& oRecordSize);
+  void decompressAndDeserializeAsync(unsigned int iLane, uint32_t const* iRecord, size_t iRecordSize, OptionalTaskHolder);
+
+  std::chrono::microseconds readTime() const;
+  std::chrono::microseconds decompressTime() const;
+  std::chrono::microseconds deserializeTime() const;
+
+  pds::Compression compression_;
+  //null if the file does not use a dictionary
+  pds::DecompressionDictionary dictionary_;
+  //only set if the file has data product references
+  std::unique_ptr<pds::ProductReferenceResolver> referenceResolver_;
+  //each data product in an event record was compressed separately
+  bool perProductCompression_ = false;
+  char const* fileBegin_ = nullptr;
+  size_t fileSize_ = 0;
+  size_t presentOffset_ = 0;
+  SerialTaskQueue queue_;
+  //empty if the file does not have an index
+  std::vector<pds::EventIndexEntry> eventIndex_;
+  unsigned long long firstEvent_;
+
+  struct LaneInfo {
+    LaneInfo(std::vector<pds::ProductInfo> const&);
+
+    LaneInfo(LaneInfo&&) = default;
+    LaneInfo(LaneInfo const&) = delete;
+
+    LaneInfo& operator=(LaneInfo&&) = default;
+    LaneInfo& operator=(LaneInfo const&) = delete;
+
+    EventIdentifier eventID_;
+    std::vector<DataProductRetriever> dataProducts_;
+    std::vector<void*> dataBuffers_;
+    MmapPDSDelayedRetriever delayedRetriever_;
+    std::chrono::microseconds decompressTime_;
+    std::chrono::microseconds deserializeTime_;
+    ~LaneInfo();
+  };
+
+  //the deserializers can be used concurrently so all lanes share them
+  DeserializeStrategy deserializers_;
+  std::vector<LaneInfo> laneInfos_;
+  std::chrono::microseconds readTime_;
+  };
+}
+
+#endif
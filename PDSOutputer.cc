@@ -2,28 +2,87 @@
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
 #include "UnrolledSerializerWrapper.h"
+#include "SpecializedSerializerWrapper.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
 #include "pds_writer.h"
+#include "common_unrolling.h"
 #include <iostream>
 #include <cstring>
 #include <set>
+#include <array>
+#include <algorithm>
 
 using namespace cce::tf;
 using namespace cce::tf::pds;
 
+namespace {
+  //same as the default used by the zstd command line tool
+  constexpr size_t kMaxDictionarySize = 112640;
+
+  //fills oColumn with the uncompressed column of data product iProductIndex using the layout
+  // described in pds_reading.h. Every event buffer holds all the data products in product index
+  // order and ioPositions gives where the data product begins in each buffer.
+  void fillColumn(uint32_t iProductIndex, std::vector<uint32_t> const* iBuffers, size_t iNEvents, std::vector<size_t>& ioPositions,
+                  std::vector<uint32_t>& oColumn) {
+    oColumn.assign(iNEvents+1, 0);
+    for(size_t e = 0; e < iNEvents; ++e) {
+      auto const& buffer = iBuffers[e];
+      auto& position = ioPositions[e];
+      assert(buffer[position] == iProductIndex);
+      auto sizeInWords = buffer[position+1];
+      oColumn[e+1] = oColumn[e]+sizeInWords;
+      oColumn.insert(oColumn.end(), buffer.begin()+position+2, buffer.begin()+position+2+sizeInWords);
+      position += 2+sizeInWords;
+    }
+  }
+}
+
+PDSOutputer::~PDSOutputer() {
+  if(not dictionaryReady_ or not batchBuffers_.empty()) {
+    //job ended before enough events were seen to finish training or to fill the last batch
+    tbb::task_group group;
+    if(not dictionaryReady_) {
+      finishDictionaryTraining(serializers_[0], group);
+    }
+    if(not batchBuffers_.empty()) {
+      finishColumnarBatchAsync(serializers_[0], group);
+    }
+    group.wait();
+  }
+  if(not firstTime_) {
+    writeEventIndex();
+  }
+  //all flushAsync calls have finished by now
+  file_.write(writeBuffer_.data(), writeBuffer_.size());
+}
+
 void PDSOutputer::setupForLane(unsigned int iLaneIndex, std::vector<DataProductRetriever> const& iDPs) {
   auto& s = serializers_[iLaneIndex];
   switch(serialization_) {
   case Serialization::kRoot:
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case Serialization::kRootUnrolled:
-    {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+    {
+      if(specializedSerializers_) {
+        s = SerializeStrategy::make<SerializeProxy<SpecializedSerializerWrapper>>();
+      } else {
+        s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>();
+      }
+      break;
+    }
+  case Serialization::kRaw:
+    {   s = SerializeStrategy::make<SerializeProxy<RawSerializerWrapper>>(); break; }
   }
+  prebuildWriteActionSequences(serialization_, iDPs);
   s.reserve(iDPs.size());
   for(auto const& dp: iDPs) {
     s.emplace_back(dp.name(), dp.classType());
   }
+  if(deduplicateProducts_ and storedProducts_.empty()) {
+    storedProducts_.resize(iDPs.size());
+    storedHashHints_ = std::make_unique<std::atomic<uint64_t>[]>(iDPs.size());
+  }
 }
 
 void PDSOutputer::productReadyAsync(unsigned int iLaneIndex, DataProductRetriever const& iDataProduct, TaskHolder iCallback) const {
@@ -34,10 +93,41 @@ void PDSOutputer::productReadyAsync(unsigned int iLaneIndex, DataProductRetrieve
 
 void PDSOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier const& iEventID, TaskHolder iCallback) const {
   auto start = std::chrono::high_resolution_clock::now();
+  if(not dictionaryReady_ or columnarBatchSize_ != 0) {
+    //can not compress until the dictionary has been made or the batch is full
+    auto tempBuffer = std::make_unique<std::vector<uint32_t>>(serializeDataProducts(serializers_[iLaneIndex]));
+    queue_.push(*iCallback.group(), [this, iEventID, iLaneIndex, callback=std::move(iCallback), buffer=std::move(tempBuffer)]() mutable {
+        auto start = std::chrono::high_resolution_clock::now();
+        const_cast<PDSOutputer*>(this)->storeUncompressed(iEventID, serializers_[iLaneIndex], std::move(*buffer), *callback.group());
+        buffer.reset();
+        serialTime_ += std::chrono::duration_cast<decltype(serialTime_)>(std::chrono::high_resolution_clock::now() - start);
+        callback.doneWaiting();
+      });
+    auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+    parallelTime_ += time.count();
+    return;
+  }
+  if(deduplicateProducts_) {
+    auto buffer = std::make_unique<std::vector<uint32_t>>(serializeDataProducts(serializers_[iLaneIndex]));
+    auto hashes = std::make_unique<std::vector<uint64_t>>(hashDataProducts(*buffer));
+    auto record = std::make_unique<std::vector<uint32_t>>(compressEachDataProduct(*buffer, hashes.get()));
+    queue_.push(*iCallback.group(), [this, iEventID, iLaneIndex, callback=std::move(iCallback), buffer=std::move(buffer), hashes=std::move(hashes), record=std::move(record)]() mutable {
+        auto start = std::chrono::high_resolution_clock::now();
+        const_cast<PDSOutputer*>(this)->outputWithReferences(iEventID, serializers_[iLaneIndex], std::move(*record), *buffer, *hashes, *callback.group());
+        bufferPool_.giveBack(std::move(*buffer));
+        buffer.reset();
+        serialTime_ += std::chrono::duration_cast<decltype(serialTime_)>(std::chrono::high_resolution_clock::now() - start);
+        callback.doneWaiting();
+      });
+    auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+    parallelTime_ += time.count();
+    return;
+  }
   auto tempBuffer = std::make_unique<std::vector<uint32_t>>(writeDataProductsToOutputBuffer(serializers_[iLaneIndex]));
   queue_.push(*iCallback.group(), [this, iEventID, iLaneIndex, callback=std::move(iCallback), buffer=std::move(tempBuffer)]() mutable {
       auto start = std::chrono::high_resolution_clock::now();
-      const_cast<PDSOutputer*>(this)->output(iEventID, serializers_[iLaneIndex],*buffer);
+      const_cast<PDSOutputer*>(this)->output(iEventID, serializers_[iLaneIndex],*buffer, *callback.group());
+      bufferPool_.giveBack(std::move(*buffer));
       buffer.reset();
         serialTime_ += std::chrono::duration_cast<decltype(serialTime_)>(std::chrono::high_resolution_clock::now() - start);
       callback.doneWaiting();
@@ -49,12 +139,22 @@ void PDSOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier const& iE
 void PDSOutputer::printSummary() const  {
   std::cout <<"PDSOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
     "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+  if(flushSize_ != 0) {
+    std::cout <<"  total buffered write time: "<<writeTime_.count()<<"us\n";
+  }
+  std::cout <<"  buffer pool allocations: "<<bufferPool_.allocations()<<" reuses: "<<bufferPool_.reuses()<<"\n";
+  if(specializedSerializers_) {
+    std::cout <<"  specialized serializers in use: "<<specialized::nInUse().load()<<"\n";
+  }
+  if(deduplicateProducts_) {
+    std::cout <<"  data products written as references: "<<nProductReferences_<<"\n";
+  }
   summarize_serializers(serializers_);
 }
 
 
 
-void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t>const& iBuffer) {
+void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t>const& iBuffer, tbb::task_group& iGroup) {
   if(firstTime_) {
     writeFileHeader(iSerializers);
     firstTime_ = false;
@@ -63,8 +163,14 @@ void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy cons
   
   //std::cout <<"   run:"s+std::to_string(iEventID.run)+" lumi:"s+std::to_string(iEventID.lumi)+" event:"s+std::to_string(iEventID.event)+"\n"<<std::flush;
   
+  //first word of the buffer is the record size
+  eventIndex_.push_back({fileOffset_, iBuffer[0], iEventID});
   writeEventHeader(iEventID);
-  file_.write(reinterpret_cast<char const*>(iBuffer.data()), (iBuffer.size())*4);
+  write(reinterpret_cast<char const*>(iBuffer.data()), (iBuffer.size())*4);
+  fileOffset_ += (pds::kEventHeaderSizeInWords+iBuffer.size())*4;
+  if(flushSize_ != 0 and writeBuffer_.size() >= flushSize_) {
+    flushAsync(iGroup);
+  }
   /*
     for(auto& s: iSerializers) {
     std::cout<<"   "s+s.name()+" size "+std::to_string(s.blob().size())+"\n" <<std::flush;
@@ -72,6 +178,99 @@ void PDSOutputer::output(EventIdentifier const& iEventID, SerializeStrategy cons
   */
 }
 
+void PDSOutputer::storeUncompressed(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iBuffer, tbb::task_group& iGroup) {
+  //another lane's event may have finished the training while this one was waiting in the queue
+  if(not dictionaryReady_) {
+    collectForDictionaryTraining(iEventID, iSerializers, std::move(iBuffer), iGroup);
+  } else if(columnarBatchSize_ != 0) {
+    addToColumnarBatch(iEventID, iSerializers, std::move(iBuffer), iGroup);
+  } else if(deduplicateProducts_) {
+    auto hashes = hashDataProducts(iBuffer);
+    auto record = compressEachDataProduct(iBuffer, &hashes);
+    outputWithReferences(iEventID, iSerializers, std::move(record), iBuffer, hashes, iGroup);
+    bufferPool_.giveBack(std::move(iBuffer));
+  } else {
+    auto cBuffer = compressEventBuffer(iBuffer);
+    bufferPool_.giveBack(std::move(iBuffer));
+    output(iEventID, iSerializers, cBuffer, iGroup);
+    bufferPool_.giveBack(std::move(cBuffer));
+  }
+}
+
+void PDSOutputer::collectForDictionaryTraining(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iBuffer, tbb::task_group& iGroup) {
+  trainingEventIDs_.push_back(iEventID);
+  trainingBuffers_.push_back(std::move(iBuffer));
+  if(trainingBuffers_.size() >= dictionaryTrainingEvents_) {
+    finishDictionaryTraining(iSerializers, iGroup);
+  }
+}
+
+void PDSOutputer::finishDictionaryTraining(SerializeStrategy const& iSerializers, tbb::task_group& iGroup) {
+  if(not trainingBuffers_.empty()) {
+    if(columnarBatchSize_ != 0) {
+      //the dictionary will be applied to each column so train on the columns the training events will be stored in
+      std::vector<std::vector<uint32_t>> samples;
+      uint32_t const nProducts = iSerializers.size();
+      for(size_t begin = 0; begin < trainingBuffers_.size(); begin += columnarBatchSize_) {
+        auto nEvents = std::min<size_t>(columnarBatchSize_, trainingBuffers_.size()-begin);
+        std::vector<size_t> positions(nEvents, 0);
+        for(uint32_t productIndex = 0; productIndex < nProducts; ++productIndex) {
+          samples.emplace_back();
+          fillColumn(productIndex, trainingBuffers_.data()+begin, nEvents, positions, samples.back());
+        }
+      }
+      dictionary_ = pds::trainDictionary(samples, kMaxDictionarySize);
+    } else if(perProductCompression_) {
+      //the dictionary will be applied to each product so train on the products
+      std::vector<std::vector<uint32_t>> samples;
+      for(auto const& b: trainingBuffers_) {
+        auto it = b.begin();
+        while(it != b.end()) {
+          ++it; //product index
+          auto size = *(it++);
+          samples.emplace_back(it, it+size);
+          it += size;
+        }
+      }
+      dictionary_ = pds::trainDictionary(samples, kMaxDictionarySize);
+    } else {
+      dictionary_ = pds::trainDictionary(trainingBuffers_, kMaxDictionarySize);
+    }
+    if(not dictionary_.empty()) {
+      compressionDictionary_ = pds::makeCompressionDictionary(dictionary_, compressionLevel_);
+    }
+  }
+  dictionaryReady_ = true;
+  for(size_t i=0; i<trainingBuffers_.size(); ++i) {
+    storeUncompressed(trainingEventIDs_[i], iSerializers, std::move(trainingBuffers_[i]), iGroup);
+  }
+  trainingEventIDs_.clear();
+  trainingBuffers_.clear();
+}
+
+void PDSOutputer::write(char const* iData, size_t iSize) {
+  if(flushSize_ == 0) {
+    file_.write(iData, iSize);
+    return;
+  }
+  writeBuffer_.insert(writeBuffer_.end(), iData, iData+iSize);
+}
+
+void PDSOutputer::flushAsync(tbb::task_group& iGroup) {
+  std::vector<char> nextBuffer;
+  if(not spareWriteBuffers_.try_pop(nextBuffer)) {
+    nextBuffer.reserve(flushSize_);
+  }
+  std::swap(nextBuffer, writeBuffer_);
+  writeQueue_.push(iGroup, [this, buffer = std::move(nextBuffer)]() mutable {
+      auto start = std::chrono::high_resolution_clock::now();
+      file_.write(buffer.data(), buffer.size());
+      buffer.clear();
+      spareWriteBuffers_.push(std::move(buffer));
+      writeTime_ += std::chrono::duration_cast<decltype(writeTime_)>(std::chrono::high_resolution_clock::now() - start);
+    });
+}
+
 void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   std::set<std::string> typeNamesSet;
   for(auto const& w: iSerializers) {
@@ -143,17 +342,26 @@ void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   
   {
     //The file type identifier
-    uint32_t comp = 0;
-    if(serialization_ == Serialization::kRootUnrolled) {
-      comp = 1;
-    }
+    const uint32_t comp = static_cast<uint32_t>(serialization_);
     const uint32_t id = 3141592*256+1 + comp;
     file_.write(reinterpret_cast<char const*>(&id), 4);
   }
   {
-    //The 'unique' file id, just dummy for now
-    const uint32_t fileID = 0;
-    file_.write(reinterpret_cast<char const*>(&fileID), 4);     
+    //The file flags
+    uint32_t flags = dictionary_.empty() ? 0 : kFileHasDictionary;
+    if(perProductCompression_) {
+      flags |= kFileHasPerProductCompression;
+    }
+    if(columnarBatchSize_ != 0) {
+      flags |= kFileHasColumnarBatches;
+    }
+    if(serialization_ == Serialization::kRaw) {
+      flags |= kFileHasLayoutFingerprint;
+    }
+    if(deduplicateProducts_) {
+      flags |= kFileHasProductReferences;
+    }
+    file_.write(reinterpret_cast<char const*>(&flags), 4);     
   }
   {
     //Compression type used
@@ -172,20 +380,75 @@ void PDSOutputer::writeFileHeader(SerializeStrategy const& iSerializers) {
   
   //The size of the header buffer in words (excluding first 3 words)
   file_.write(reinterpret_cast<char const*>(&bufferSize), 4);
+
+  fileOffset_ += (4+bufferSize+1)*4;
+
+  if(not dictionary_.empty()) {
+    //size in bytes, the dictionary padded to a word boundary, then the size again
+    const uint32_t dictionarySize = dictionary_.size();
+    std::vector<uint32_t> dictionaryBuffer(2+bytesToWords(dictionarySize), 0);
+    dictionaryBuffer.front() = dictionarySize;
+    std::memcpy(dictionaryBuffer.data()+1, dictionary_.data(), dictionarySize);
+    dictionaryBuffer.back() = dictionarySize;
+    file_.write(reinterpret_cast<char const*>(dictionaryBuffer.data()), dictionaryBuffer.size()*4);
+    fileOffset_ += dictionaryBuffer.size()*4;
+  }
+
+  if(serialization_ == Serialization::kRaw) {
+    std::vector<std::string> classNames;
+    classNames.reserve(iSerializers.size());
+    for(auto const& s: iSerializers) {
+      classNames.emplace_back(s.className());
+    }
+    const uint64_t fingerprint = unrolling::rawLayoutFingerprint(classNames);
+    const std::array<uint32_t,2> fingerprintWords = {static_cast<uint32_t>(fingerprint & 0xFFFFFFFF), static_cast<uint32_t>(fingerprint >> 32)};
+    file_.write(reinterpret_cast<char const*>(fingerprintWords.data()), 2*4);
+    fileOffset_ += 2*4;
+  }
 }
 
-void PDSOutputer::writeEventHeader(EventIdentifier const& iEventID) {
-  constexpr unsigned int headerBufferSizeInWords = 5;
+void PDSOutputer::writeEventIndex() {
+  std::vector<uint32_t> buffer(2+eventIndex_.size()*kEventIndexEntrySizeInWords+kEventIndexFooterSizeInWords, 0);
+  auto it = buffer.begin();
+  *(it++) = kEventIndexRecordMarker;
+  *(it++) = eventIndex_.size();
+  for(auto const& entry: eventIndex_) {
+    *(it++) = entry.offset & 0xFFFFFFFF;
+    *(it++) = (entry.offset >> 32) & 0xFFFFFFFF;
+    *(it++) = entry.recordSize;
+    *(it++) = entry.eventID.run;
+    *(it++) = entry.eventID.lumi;
+    *(it++) = (entry.eventID.event >> 32) & 0xFFFFFFFF;
+    *(it++) = entry.eventID.event & 0xFFFFFFFF;
+  }
+  //footer gives where the index starts
+  *(it++) = fileOffset_ & 0xFFFFFFFF;
+  *(it++) = (fileOffset_ >> 32) & 0xFFFFFFFF;
+  *(it++) = kEventIndexFooterMarker;
+  assert(it == buffer.end());
+  write(reinterpret_cast<char const*>(buffer.data()), buffer.size()*4);
+  fileOffset_ += buffer.size()*4;
+}
+
+void PDSOutputer::writeEventHeader(EventIdentifier const& iEventID, uint32_t iRecordType) {
+  constexpr unsigned int headerBufferSizeInWords = pds::kEventHeaderSizeInWords;
   std::array<uint32_t,headerBufferSizeInWords> buffer;
-  buffer[0] = 0; //Record index for Event
+  buffer[0] = iRecordType; //Record index for Event
   buffer[1] = iEventID.run;
   buffer[2] = iEventID.lumi;
   buffer[3] = (iEventID.event >> 32) & 0xFFFFFFFF;
   buffer[4] = iEventID.event & 0xFFFFFFFF;
-  file_.write(reinterpret_cast<char const*>(buffer.data()), headerBufferSizeInWords*4);
+  write(reinterpret_cast<char const*>(buffer.data()), headerBufferSizeInWords*4);
 }
 
 std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers) const{
+  auto buffer = serializeDataProducts(iSerializers);
+  auto cBuffer = compressEventBuffer(buffer);
+  bufferPool_.giveBack(std::move(buffer));
+  return cBuffer;
+}
+
+std::vector<uint32_t> PDSOutputer::serializeDataProducts(SerializeStrategy const& iSerializers) const{
   //Calculate buffer size needed
   uint32_t bufferSize = 0;
   for(auto const& s: iSerializers) {
@@ -194,7 +457,8 @@ std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStra
     bufferSize += bytesToWords(blobSize); //handles padding
   }
   //initialize with 0
-  std::vector<uint32_t> buffer(size_t(bufferSize), 0);
+  std::vector<uint32_t> buffer = bufferPool_.get(bufferSize);
+  buffer.resize(bufferSize, 0);
   
   {
     uint32_t bufferIndex = 0;
@@ -209,8 +473,16 @@ std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStra
     }
     assert(buffer.size() == bufferIndex);
   }
+  return buffer;
+}
 
-  auto [cBuffer,cSize] = compressBuffer(2, 1, buffer);
+std::vector<uint32_t> PDSOutputer::compressEventBuffer(std::vector<uint32_t> const& buffer) const {
+  if(perProductCompression_) {
+    return compressEachDataProduct(buffer);
+  }
+  //the compressed size is usually less than the uncompressed size
+  std::vector<uint32_t> cBuffer = bufferPool_.get(buffer.size()+buffer.size()/128+32);
+  auto cSize = pds::compressBuffer(2, 1, compression_, compressionLevel_, buffer.data(), buffer.size(), cBuffer, compressionDictionary_.get());
 
   //std::cout <<"compressed "<<cSize<<" uncompressed "<<buffer.size()*4<<std::endl;
   //std::cout <<"compressed "<<(buffer.size()*4)/float(cSize)<<std::endl;
@@ -227,8 +499,202 @@ std::vector<uint32_t> PDSOutputer::writeDataProductsToOutputBuffer(SerializeStra
   return cBuffer;
 }
 
-std::pair<std::vector<uint32_t>,int> PDSOutputer::compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer) const {
-  return pds::compressBuffer(iLeadPadding, iTrailingPadding, compression_, compressionLevel_, iBuffer);
+std::vector<uint32_t> PDSOutputer::compressEachDataProduct(std::vector<uint32_t> const& buffer, std::vector<uint64_t> const* iHashes) const {
+  //first word is the record size, last word is the crosscheck
+  std::vector<uint32_t> cBuffer = bufferPool_.get(buffer.size()+buffer.size()/128+32);
+  cBuffer.push_back(0);
+  size_t index = 0;
+  while(index < buffer.size()) {
+    auto productIndex = buffer[index++];
+    auto sizeInWords = buffer[index++];
+    if(iHashes and storedHashHints_[productIndex].load(std::memory_order_relaxed) == (*iHashes)[productIndex]) {
+      cBuffer.push_back(productIndex);
+      cBuffer.push_back(kProductReferenceBit | kProductReferenceSizeInWords);
+      cBuffer.insert(cBuffer.end(), kProductReferenceSizeInWords, 0);
+    } else {
+      appendCompressedProduct(productIndex, buffer.data()+index, sizeInWords, cBuffer);
+    }
+    index += sizeInWords;
+  }
+  assert(index == buffer.size());
+  uint32_t const recordSize = cBuffer.size()-1;
+  cBuffer[0] = recordSize;
+  cBuffer.push_back(recordSize);
+  return cBuffer;
+}
+
+std::vector<uint64_t> PDSOutputer::hashDataProducts(std::vector<uint32_t> const& iBuffer) const {
+  std::vector<uint64_t> hashes(serializers_[0].size(), 0);
+  size_t index = 0;
+  while(index < iBuffer.size()) {
+    auto productIndex = iBuffer[index++];
+    auto sizeInWords = iBuffer[index++];
+    hashes[productIndex] = pds::hashWords(iBuffer.data()+index, sizeInWords);
+    index += sizeInWords;
+  }
+  return hashes;
+}
+
+void PDSOutputer::replaceDuplicateProducts(std::vector<uint32_t>& ioRecord, std::vector<uint32_t> const& iUncompressed, std::vector<uint64_t> const& iHashes) {
+  std::vector<uint32_t> record = bufferPool_.get(ioRecord.size());
+  record.push_back(0);
+  //skip the leading record size and the trailing crosscheck
+  size_t index = 1;
+  size_t const end = ioRecord.size()-1;
+  //the data products are in the same order in both buffers
+  size_t uIndex = 0;
+  while(index < end) {
+    auto productIndex = ioRecord[index];
+    auto storedSize = ioRecord[index+1];
+    bool const isPlaceholder = storedSize & kProductReferenceBit;
+    auto const sizeInWords = storedSize & ~kProductReferenceBit;
+    assert(iUncompressed[uIndex] == productIndex);
+    auto const* uncompressed = iUncompressed.data()+uIndex+2;
+    auto const uncompressedSize = iUncompressed[uIndex+1];
+    uIndex += 2+uncompressedSize;
+    auto& stored = storedProducts_[productIndex];
+    //a hash collision must not make readers use a different data product
+    if(stored.stored_ and stored.hash_ == iHashes[productIndex] and stored.words_.size() == uncompressedSize
+       and std::equal(stored.words_.begin(), stored.words_.end(), uncompressed)) {
+      record.push_back(productIndex);
+      record.push_back(kProductReferenceBit | kProductReferenceSizeInWords);
+      record.push_back(stored.recordOffset_ & 0xFFFFFFFF);
+      record.push_back((stored.recordOffset_ >> 32) & 0xFFFFFFFF);
+      ++nProductReferences_;
+    } else {
+      if(isPlaceholder) {
+        //the data product changed after the lane checked, so it must be compressed now
+        appendCompressedProduct(productIndex, uncompressed, uncompressedSize, record);
+      } else {
+        record.insert(record.end(), ioRecord.begin()+index, ioRecord.begin()+index+2+sizeInWords);
+      }
+      stored.hash_ = iHashes[productIndex];
+      stored.recordOffset_ = fileOffset_;
+      stored.words_.assign(uncompressed, uncompressed+uncompressedSize);
+      stored.stored_ = true;
+      storedHashHints_[productIndex].store(iHashes[productIndex], std::memory_order_relaxed);
+    }
+    index += 2+sizeInWords;
+  }
+  assert(index == end);
+  assert(uIndex == iUncompressed.size());
+  uint32_t const recordSize = record.size()-1;
+  record[0] = recordSize;
+  record.push_back(recordSize);
+  std::swap(ioRecord, record);
+  bufferPool_.giveBack(std::move(record));
+}
+
+void PDSOutputer::outputWithReferences(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iRecord,
+                                       std::vector<uint32_t> const& iUncompressed, std::vector<uint64_t> const& iHashes, tbb::task_group& iGroup) {
+  //the references hold file offsets so the header must already be written
+  if(firstTime_) {
+    writeFileHeader(iSerializers);
+    firstTime_ = false;
+  }
+  replaceDuplicateProducts(iRecord, iUncompressed, iHashes);
+  output(iEventID, iSerializers, iRecord, iGroup);
+  bufferPool_.giveBack(std::move(iRecord));
+}
+
+void PDSOutputer::appendCompressedProduct(uint32_t iProductIndex, uint32_t const* iData, size_t iSizeInWords, std::vector<uint32_t>& ioRecord) const {
+  //leave room for the product index, the compressed size, and the uncompressed size
+  std::vector<uint32_t> cProduct = bufferPool_.get(iSizeInWords+iSizeInWords/128+32);
+  auto cSize = pds::compressBuffer(3, 0, compression_, compressionLevel_, iData, iSizeInWords, cProduct, compressionDictionary_.get());
+  cProduct[0] = iProductIndex;
+  cProduct[1] = cProduct.size()-2;
+  //same encoding as the whole event record
+  cProduct[2] = iSizeInWords*4 + (cSize % 4);
+  assert(cProduct[1] == bytesToWords(cSize)+1);
+  ioRecord.insert(ioRecord.end(), cProduct.begin(), cProduct.end());
+  bufferPool_.giveBack(std::move(cProduct));
+}
+
+void PDSOutputer::addToColumnarBatch(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iBuffer, tbb::task_group& iGroup) {
+  batchEventIDs_.push_back(iEventID);
+  batchBuffers_.push_back(std::move(iBuffer));
+  if(batchBuffers_.size() >= columnarBatchSize_) {
+    finishColumnarBatchAsync(iSerializers, iGroup);
+  }
+}
+
+void PDSOutputer::finishColumnarBatchAsync(SerializeStrategy const& iSerializers, tbb::task_group& iGroup) {
+  auto eventIDs = std::make_shared<std::vector<EventIdentifier>>(std::move(batchEventIDs_));
+  auto buffers = std::make_shared<std::vector<std::vector<uint32_t>>>(std::move(batchBuffers_));
+  batchEventIDs_.clear();
+  batchBuffers_.clear();
+  auto sequence = nextBatchSequence_++;
+  //compressing the columns is the expensive part so keep it out of the serial queue
+  iGroup.run([this, &iSerializers, &iGroup, eventIDs, buffers, sequence]() {
+      auto start = std::chrono::high_resolution_clock::now();
+      auto record = std::make_shared<std::vector<uint32_t>>(makeColumnarBatchRecord(*eventIDs, *buffers));
+      for(auto& b: *buffers) {
+        bufferPool_.giveBack(std::move(b));
+      }
+      queue_.push(iGroup, [this, &iSerializers, &iGroup, eventIDs, record, sequence]() {
+          auto start = std::chrono::high_resolution_clock::now();
+          auto self = const_cast<PDSOutputer*>(this);
+          self->compressedBatches_.emplace(sequence, CompressedBatch{eventIDs, record});
+          self->writeCompressedBatches(iSerializers, iGroup);
+          serialTime_ += std::chrono::duration_cast<decltype(serialTime_)>(std::chrono::high_resolution_clock::now() - start);
+        });
+      auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+      parallelTime_ += time.count();
+    });
+}
+
+void PDSOutputer::writeCompressedBatches(SerializeStrategy const& iSerializers, tbb::task_group& iGroup) {
+  //a batch whose compression finished early waits for the ones made before it
+  auto it = compressedBatches_.begin();
+  while(it != compressedBatches_.end() and it->first == nextBatchToWrite_) {
+    outputColumnarBatch(*it->second.eventIDs_, iSerializers, *it->second.record_, iGroup);
+    ++nextBatchToWrite_;
+    it = compressedBatches_.erase(it);
+  }
+}
+
+std::vector<uint32_t> PDSOutputer::makeColumnarBatchRecord(std::vector<EventIdentifier> const& iEventIDs, std::vector<std::vector<uint32_t>> const& iBuffers) const {
+  assert(iEventIDs.size() == iBuffers.size());
+  uint32_t const nEvents = iEventIDs.size();
+  //first word is the record size, last word is the crosscheck
+  std::vector<uint32_t> record(1, 0);
+  record.push_back(nEvents);
+  for(auto const& id: iEventIDs) {
+    record.push_back(id.run);
+    record.push_back(id.lumi);
+    record.push_back((id.event >> 32) & 0xFFFFFFFF);
+    record.push_back(id.event & 0xFFFFFFFF);
+  }
+
+  std::vector<size_t> positions(nEvents, 0);
+  std::vector<uint32_t> column;
+  //the file header may not have been written yet
+  uint32_t const nProducts = serializers_[0].size();
+  for(uint32_t productIndex = 0; productIndex < nProducts; ++productIndex) {
+    fillColumn(productIndex, iBuffers.data(), nEvents, positions, column);
+    appendCompressedProduct(productIndex, column.data(), column.size(), record);
+  }
+  uint32_t const recordSize = record.size()-1;
+  record[0] = recordSize;
+  record.push_back(recordSize);
+  return record;
+}
+
+void PDSOutputer::outputColumnarBatch(std::vector<EventIdentifier> const& iEventIDs, SerializeStrategy const& iSerializers, std::vector<uint32_t> const& iRecord, tbb::task_group& iGroup) {
+  if(firstTime_) {
+    writeFileHeader(iSerializers);
+    firstTime_ = false;
+  }
+  //every event of the batch refers to the batch record
+  for(auto const& id: iEventIDs) {
+    eventIndex_.push_back({fileOffset_, iRecord[0], id});
+  }
+  writeEventHeader(iEventIDs.front(), kColumnarBatchRecordType);
+  write(reinterpret_cast<char const*>(iRecord.data()), iRecord.size()*4);
+  fileOffset_ += (pds::kEventHeaderSizeInWords+iRecord.size())*4;
+  if(flushSize_ != 0 and writeBuffer_.size() >= flushSize_) {
+    flushAsync(iGroup);
+  }
 }
 
 namespace {
@@ -246,6 +712,11 @@ namespace {
       }
 
       int compressionLevel = params.get<int>("compressionLevel", 18);
+      unsigned int flushSize = params.get<unsigned int>("flushSize", 0);
+      unsigned int dictionaryTrainingEvents = params.get<unsigned int>("dictionaryTrainingEvents", 0);
+      bool perProductCompression = params.get<bool>("perProductCompression", false);
+      bool deduplicateProducts = params.get<bool>("deduplicateProducts", false);
+      unsigned int columnarBatchSize = params.get<unsigned int>("columnarBatchSize", 0);
 
       auto compressionName = params.get<std::string>("compressionAlgorithm", "ZSTD");
       auto serializationName = params.get<std::string>("serializationAlgorithm", "ROOT");
@@ -261,8 +732,27 @@ namespace {
         std::cout <<"unknown serialization "<<serializationName<<std::endl;
         return {};
       }
+
+      bool specializedSerializers = params.get<bool>("specializedSerializers", false);
+      if(specializedSerializers and *serialization != pds::Serialization::kRootUnrolled) {
+        std::cout <<"specializedSerializers can only be used with the Unrolled serialization"<<std::endl;
+        return {};
+      }
+      
+      if(dictionaryTrainingEvents != 0 and *compression != pds::Compression::kZSTD) {
+        std::cout <<"dictionaryTrainingEvents can only be used with ZSTD compression"<<std::endl;
+        return {};
+      }
+      if(deduplicateProducts and not perProductCompression) {
+        std::cout <<"deduplicateProducts requires perProductCompression"<<std::endl;
+        return {};
+      }
+      if(perProductCompression and columnarBatchSize != 0) {
+        std::cout <<"perProductCompression and columnarBatchSize can not be used together"<<std::endl;
+        return {};
+      }
       
-      return std::make_unique<PDSOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization);
+      return std::make_unique<PDSOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization, specializedSerializers, flushSize, dictionaryTrainingEvents, perProductCompression, deduplicateProducts, columnarBatchSize);
     }
     
   };
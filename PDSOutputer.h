@@ -5,28 +5,52 @@
 #include <string>
 #include <cstdint>
 #include <fstream>
+#include <map>
+#include <memory>
 
 #include "OutputerBase.h"
 #include "EventIdentifier.h"
 #include "SerializeStrategy.h"
 #include "DataProductRetriever.h"
 #include "pds_common.h"
+#include "pds_writer.h"
+#include "BufferPool.h"
 
 #include "SerialTaskQueue.h"
+#include "tbb/concurrent_queue.h"
 
 namespace cce::tf {
 class PDSOutputer :public OutputerBase {
  public:
+ //iFlushSize is the number of bytes collected before writing to the file. 0 means write each event immediately.
+ //iDictionaryTrainingEvents is the number of events used to train a ZSTD dictionary. 0 means no dictionary.
+ //iPerProductCompression compresses each data product separately so readers can decompress only the products they need.
+ //iSpecializedSerializers uses the serializers registered in SpecializedSerializer.h when using the unrolled serialization.
+ //iDeduplicateProducts writes a reference instead of a data product identical to the last one stored for that product. Requires iPerProductCompression.
+ //iColumnarBatchSize is the number of events stored together in a columnar batch record. 0 means events are stored individually.
  PDSOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, 
-             pds::Serialization iSerialization ): 
+             pds::Serialization iSerialization, bool iSpecializedSerializers, size_t iFlushSize, unsigned int iDictionaryTrainingEvents, bool iPerProductCompression,
+             bool iDeduplicateProducts, unsigned int iColumnarBatchSize ): 
   file_(iFileName, std::ios_base::out| std::ios_base::binary),
   serializers_{std::size_t(iNLanes)},
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
   serialization_{iSerialization},
+  specializedSerializers_{iSpecializedSerializers},
+  flushSize_{iFlushSize},
+  dictionaryTrainingEvents_{iDictionaryTrainingEvents},
+  dictionaryReady_{iDictionaryTrainingEvents == 0},
+  perProductCompression_{iPerProductCompression},
+  deduplicateProducts_{iDeduplicateProducts},
+  columnarBatchSize_{iColumnarBatchSize},
   serialTime_{std::chrono::microseconds::zero()},
+  writeTime_{std::chrono::microseconds::zero()},
   parallelTime_{0}
-  {}
+  {
+    writeBuffer_.reserve(flushSize_);
+  }
+
+  ~PDSOutputer();
 
   void setupForLane(unsigned int iLaneIndex, std::vector<DataProductRetriever> const& iDPs) final;
 
@@ -42,13 +66,45 @@ class PDSOutputer :public OutputerBase {
     return nBytes/4 + ( (nBytes % 4) == 0 ? 0 : 1);
   }
 
-  void output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> const& iBuffer);
+  void output(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> const& iBuffer, tbb::task_group& iGroup);
+  //called from queue_ with the uncompressed event when compression can not be done before reaching the queue
+  void storeUncompressed(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iBuffer, tbb::task_group& iGroup);
+  void addToColumnarBatch(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iBuffer, tbb::task_group& iGroup);
+  //compresses the batch in a new task then writes it from queue_
+  void finishColumnarBatchAsync(SerializeStrategy const& iSerializers, tbb::task_group& iGroup);
+  //called from queue_, writes the compressed batches which are next in the order the batches were made
+  void writeCompressedBatches(SerializeStrategy const& iSerializers, tbb::task_group& iGroup);
+  void outputColumnarBatch(std::vector<EventIdentifier> const& iEventIDs, SerializeStrategy const& iSerializers, std::vector<uint32_t> const& iRecord, tbb::task_group& iGroup);
+  //either writes to the file or appends to writeBuffer_
+  void write(char const* iData, size_t iSize);
+  //hands writeBuffer_ to writeQueue_ and starts filling another buffer
+  void flushAsync(tbb::task_group& iGroup);
   void writeFileHeader(SerializeStrategy const& iSerializers);
 
-  void writeEventHeader(EventIdentifier const& iEventID);
+  void writeEventHeader(EventIdentifier const& iEventID, uint32_t iRecordType = pds::kEventRecordType);
+  void writeEventIndex();
   std::vector<uint32_t> writeDataProductsToOutputBuffer(SerializeStrategy const& iSerializers) const;
+  //the uncompressed buffer holding all the data products
+  std::vector<uint32_t> serializeDataProducts(SerializeStrategy const& iSerializers) const;
+  //the compressed buffer with the leading record size and trailing crosscheck words
+  std::vector<uint32_t> compressEventBuffer(std::vector<uint32_t> const& iBuffer) const;
+  //same as compressEventBuffer but uses the per product layout described in pds_reading.h
+  //If iHashes is given, data products which look unchanged are not compressed but get a
+  // placeholder reference which replaceDuplicateProducts resolves.
+  std::vector<uint32_t> compressEachDataProduct(std::vector<uint32_t> const& iBuffer, std::vector<uint64_t> const* iHashes = nullptr) const;
+  //indexed by product index
+  std::vector<uint64_t> hashDataProducts(std::vector<uint32_t> const& iBuffer) const;
+  //called from queue_ just before the record is written at fileOffset_
+  void replaceDuplicateProducts(std::vector<uint32_t>& ioRecord, std::vector<uint32_t> const& iUncompressed, std::vector<uint64_t> const& iHashes);
+  void outputWithReferences(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iRecord,
+                            std::vector<uint32_t> const& iUncompressed, std::vector<uint64_t> const& iHashes, tbb::task_group& iGroup);
+  //the columnar batch record with the leading record size and trailing crosscheck words
+  std::vector<uint32_t> makeColumnarBatchRecord(std::vector<EventIdentifier> const& iEventIDs, std::vector<std::vector<uint32_t>> const& iBuffers) const;
+  //appends the product index, the compressed size and the compressed data
+  void appendCompressedProduct(uint32_t iProductIndex, uint32_t const* iData, size_t iSizeInWords, std::vector<uint32_t>& ioRecord) const;
 
-  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, std::vector<uint32_t> const& iBuffer) const;
+  void collectForDictionaryTraining(EventIdentifier const& iEventID, SerializeStrategy const& iSerializers, std::vector<uint32_t> iBuffer, tbb::task_group& iGroup);
+  void finishDictionaryTraining(SerializeStrategy const& iSerializers, tbb::task_group& iGroup);
 
 private:
   std::ofstream file_;
@@ -59,8 +115,52 @@ private:
   pds::Compression compression_;
   int compressionLevel_;
   pds::Serialization serialization_;
+  bool specializedSerializers_;
   bool firstTime_ = true;
+  uint64_t fileOffset_ = 0;
+  std::vector<pds::EventIndexEntry> eventIndex_;
+  size_t flushSize_;
+  std::vector<char> writeBuffer_;
+  //buffers not presently being filled or written
+  tbb::concurrent_queue<std::vector<char>> spareWriteBuffers_;
+  //only task allowed to call file_.write once events are being buffered
+  SerialTaskQueue writeQueue_;
+  unsigned int dictionaryTrainingEvents_;
+  std::atomic<bool> dictionaryReady_;
+  std::vector<EventIdentifier> trainingEventIDs_;
+  std::vector<std::vector<uint32_t>> trainingBuffers_;
+  std::vector<char> dictionary_;
+  pds::CompressionDictionary compressionDictionary_;
+  bool perProductCompression_;
+  bool deduplicateProducts_;
+  //the last data product written to the file for each product index, only used from queue_
+  struct StoredProduct {
+    //only used to quickly skip products which changed, equal hashes still need equal words_
+    uint64_t hash_ = 0;
+    uint64_t recordOffset_ = 0;
+    std::vector<uint32_t> words_;
+    bool stored_ = false;
+  };
+  std::vector<StoredProduct> storedProducts_;
+  //copies of the hashes in storedProducts_ read by the lanes to skip compressing unchanged
+  // data products. A stale value only means the compression is done later from queue_.
+  std::unique_ptr<std::atomic<uint64_t>[]> storedHashHints_;
+  unsigned long long nProductReferences_ = 0;
+  unsigned int columnarBatchSize_;
+  std::vector<EventIdentifier> batchEventIDs_;
+  std::vector<std::vector<uint32_t>> batchBuffers_;
+  //batches are compressed concurrently and wait here, keyed by the order they were made, to be written
+  struct CompressedBatch {
+    std::shared_ptr<std::vector<EventIdentifier>> eventIDs_;
+    std::shared_ptr<std::vector<uint32_t>> record_;
+  };
+  std::map<unsigned long long, CompressedBatch> compressedBatches_;
+  unsigned long long nextBatchSequence_ = 0;
+  unsigned long long nextBatchToWrite_ = 0;
+  //holds both the uncompressed and compressed event buffers
+  mutable BufferPool<uint32_t> bufferPool_;
   mutable std::chrono::microseconds serialTime_;
+  std::chrono::microseconds writeTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
 };
 }
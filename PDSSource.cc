@@ -3,15 +3,24 @@
 #include "SourceFactory.h"
 #include "ReplicatedSharedSource.h"
 
-#include "Deserializer.h"
-#include "UnrolledDeserializer.h"
+#include <stdexcept>
 
 using namespace cce::tf;
 using namespace cce::tf::pds;
 
 
 bool PDSSource::readEvent(long iEventIndex) {
-  while(iEventIndex != presentEventIndex_) {
+  auto fileEventIndex = firstEvent_+iEventIndex;
+  if(not eventIndex_.empty()) {
+    if(fileEventIndex >= eventIndex_.size()) {
+      return false;
+    }
+    if(fileEventIndex != presentEventIndex_) {
+      file_.seekg(eventIndex_[fileEventIndex].offset);
+      presentEventIndex_ = fileEventIndex;
+    }
+  }
+  while(fileEventIndex != presentEventIndex_) {
     auto skipped = skipToNextEvent(file_);
     if(not skipped) {return false;}
     ++presentEventIndex_;
@@ -30,31 +39,37 @@ bool PDSSource::readEventContent() {
   }
   //last entry in buffer is a crosscheck on its size
   buffer.pop_back();
-  std::vector<uint32_t> uBuffer = uncompressEventBuffer(compression_, buffer);
-  deserializeDataProducts(uBuffer.begin(), uBuffer.end(), dataProducts_, deserializers_);
+  std::vector<uint32_t> uBuffer = perProductCompression_ ? uncompressPerProductEventBuffer(compression_, buffer.data(), buffer.size(), dictionary_.get(), referenceResolver_.get())
+    : uncompressEventBuffer(compression_, buffer, dictionary_.get());
+  deserializeDataProducts(uBuffer.begin(), uBuffer.end(), dataProducts_, deserializers_, 0);
 
   return true;
 }
 
-PDSSource::PDSSource(std::string const& iName) :
+PDSSource::PDSSource(std::string const& iName, unsigned long long iFirstEvent) :
                  SourceBase(),
-  file_{iName, std::ios_base::binary}
+  file_{iName, std::ios_base::binary},
+  firstEvent_{iFirstEvent}
 {
   pds::Serialization serialization;
-  auto productInfo = readFileHeader(file_, compression_, serialization);
-
-  switch(serialization) {
-  case pds::Serialization::kRoot: { 
-    deserializers_ = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
-  }
-  case pds::Serialization::kRootUnrolled: {
-    deserializers_ = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
+  std::vector<char> dictionary;
+  uint32_t flags;
+  uint64_t layoutFingerprint;
+  auto productInfo = readFileHeader(file_, compression_, serialization, dictionary, flags, layoutFingerprint);
+  checkLayoutFingerprint(serialization, productInfo, layoutFingerprint);
+  dictionary_ = pds::makeDecompressionDictionary(dictionary);
+  perProductCompression_ = flags & pds::kFileHasPerProductCompression;
+  if(flags & pds::kFileHasProductReferences) {
+    referenceResolver_ = std::make_unique<pds::ProductReferenceResolver>(iName, compression_, dictionary_.get(), productInfo.size());
   }
+  if(flags & pds::kFileHasColumnarBatches) {
+    throw std::runtime_error("ReplicatedPDSSource can not read columnar batches, use SharedPDSSource");
   }
+  eventIndex_ = readEventIndex(file_);
 
+  deserializers_ = makeDeserializeStrategy(serialization, productInfo, 1);
   dataProducts_.reserve(productInfo.size());
   dataBuffers_.resize(productInfo.size(), nullptr);
-  deserializers_.reserve(productInfo.size());
   size_t index =0;
   for(auto const& pi : productInfo) {
     
@@ -66,7 +81,6 @@ PDSSource::PDSSource(std::string const& iName) :
                                pi.name(),
                                cls,
 			       &delayedRetriever_);
-    deserializers_.emplace_back(cls);
     ++index;
   }
 }
@@ -89,7 +103,8 @@ namespace {
           std::cout <<"no file name given\n";
           return {};
         }
-        return std::make_unique<ReplicatedSharedSource<PDSSource>>(iNLanes, iNEvents, *fileName);
+        unsigned long long firstEvent = params.get<unsigned int>("firstEvent", 0);
+        return std::make_unique<ReplicatedSharedSource<PDSSource>>(iNLanes, iNEvents, *fileName, firstEvent);
     }
     };
 
@@ -21,7 +21,7 @@ class PDSDelayedRetriever : public DelayedProductRetriever {
 
 class PDSSource : public SourceBase {
 public:
-  PDSSource(std::string const& iName);
+  PDSSource(std::string const& iName, unsigned long long iFirstEvent=0);
   PDSSource(PDSSource&&) = default;
   PDSSource(PDSSource const&) = default;
   ~PDSSource();
@@ -36,8 +36,18 @@ private:
   bool readEventContent();
 
   pds::Compression compression_;
+  //null if the file does not use a dictionary
+  pds::DecompressionDictionary dictionary_;
+  //only set if the file has data product references
+  std::unique_ptr<pds::ProductReferenceResolver> referenceResolver_;
+  //each data product in an event record was compressed separately
+  bool perProductCompression_ = false;
   std::ifstream file_;
-  long presentEventIndex_ = 0;
+  //index of the event in the file the stream is presently positioned at
+  unsigned long long presentEventIndex_ = 0;
+  unsigned long long firstEvent_;
+  //empty if the file does not have an index
+  std::vector<pds::EventIndexEntry> eventIndex_;
   EventIdentifier eventID_;
   std::vector<DataProductRetriever> dataProducts_;
   DeserializeStrategy deserializers_;
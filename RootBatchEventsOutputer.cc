@@ -2,6 +2,8 @@
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
 #include "UnrolledSerializerWrapper.h"
+#include "SpecializedSerializerWrapper.h"
+#include "common_unrolling.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
 #include "FunctorTask.h"
@@ -15,7 +17,7 @@ using namespace cce::tf;
 using namespace cce::tf::pds;
 
 RootBatchEventsOutputer::RootBatchEventsOutputer(std::string const& iFileName, unsigned int iNLanes, Compression iCompression, int iCompressionLevel, 
-                                                 Serialization iSerialization, int autoFlush, int maxVirtualSize,
+                                                 Serialization iSerialization, bool iSpecializedSerializers, int autoFlush, int maxVirtualSize,
                                                  std::string const& iTFileCompression, int iTFileCompressionLevel,
                                                  uint32_t iBatchSize): 
   file_(iFileName.c_str(), "recreate", "", iTFileCompressionLevel),
@@ -27,6 +29,7 @@ RootBatchEventsOutputer::RootBatchEventsOutputer(std::string const& iFileName, u
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
   serialization_{iSerialization},
+  specializedSerializers_{iSpecializedSerializers},
   serialTime_{std::chrono::microseconds::zero()},
   parallelTime_{0}
   {
@@ -79,8 +82,18 @@ void RootBatchEventsOutputer::setupForLane(unsigned int iLaneIndex, std::vector<
   case Serialization::kRoot:
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case Serialization::kRootUnrolled:
-    {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+    {
+      if(specializedSerializers_) {
+        s = SerializeStrategy::make<SerializeProxy<SpecializedSerializerWrapper>>();
+      } else {
+        s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>();
+      }
+      break;
+    }
+  case Serialization::kRaw:
+    {   s = SerializeStrategy::make<SerializeProxy<RawSerializerWrapper>>(); break; }
   }
+  prebuildWriteActionSequences(serialization_, iDPs);
   s.reserve(iDPs.size());
   offsetsAndBlob_.first.resize(iDPs.size()+1,0);
   for(auto const& dp: iDPs) {
@@ -161,6 +174,10 @@ void RootBatchEventsOutputer::printSummary() const  {
 
   std::cout <<"RootBatchEventsOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
     "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+  std::cout <<"  buffer pool allocations: "<<bufferPool_.allocations()<<" reuses: "<<bufferPool_.reuses()<<"\n";
+  if(specializedSerializers_) {
+    std::cout <<"  specialized serializers in use: "<<specialized::nInUse().load()<<"\n";
+  }
 
 
   start = std::chrono::high_resolution_clock::now();
@@ -202,11 +219,11 @@ void RootBatchEventsOutputer::finishBatchAsync(unsigned int iBatchIndex, TaskHol
     std::copy(blob.begin(), blob.end(), std::back_inserter(batchBlob));
 
     //release memory
-    blob = std::vector<char>();
+    bufferPool_.giveBack(std::move(blob));
   }
 
   auto compressedBlob = compressBuffer(batchBlob);
-  batchBlob = std::vector<char>();
+  bufferPool_.giveBack(std::move(batchBlob));
 
   
   queue_.push(*iCallback.group(), [this, eventIDs=std::move(batchEventIDs), offsets = std::move(batchOffsets), buffer = std::move(compressedBlob),  callback=std::move(iCallback)]() mutable {
@@ -225,6 +242,7 @@ void RootBatchEventsOutputer::output(std::vector<EventIdentifier> iEventIDs, std
 
   eventsTree_->Fill();
 
+  bufferPool_.giveBack(std::move(offsetsAndBlob_.second));
   offsetsAndBlob_ = {};
 }
 
@@ -244,6 +262,16 @@ void RootBatchEventsOutputer::writeMetaData(SerializeStrategy const& iSerializer
   meta->Branch("DataProducts",&typeAndNames, 0, 0);
   meta->Branch("objectSerializationUsed",&objectSerializationUsed);
   meta->Branch("compressionAlgorithm",&compression,0,0);
+  ULong64_t layoutFingerprint = 0;
+  if(serialization_ == Serialization::kRaw) {
+    std::vector<std::string> classNames;
+    classNames.reserve(typeAndNames.size());
+    for(auto const& tn: typeAndNames) {
+      classNames.push_back(tn.first);
+    }
+    layoutFingerprint = unrolling::rawLayoutFingerprint(classNames);
+    meta->Branch("layoutFingerprint",&layoutFingerprint);
+  }
 
   meta->Fill();
 
@@ -262,7 +290,8 @@ std::pair<std::vector<uint32_t>, std::vector<char>> RootBatchEventsOutputer::wri
   offsets.push_back(bufferSize);
 
   //initialize with 0
-  std::vector<char> buffer(bufferSize, 0);
+  std::vector<char> buffer = bufferPool_.get(bufferSize);
+  buffer.resize(bufferSize, 0);
   
   {
     uint32_t index = 0;
@@ -276,11 +305,13 @@ std::pair<std::vector<uint32_t>, std::vector<char>> RootBatchEventsOutputer::wri
 
   //std::cout <<"compressed "<<cSize<<" uncompressed "<<buffer.size()<<std::endl;
   //std::cout <<"compressed "<<(buffer.size())/float(cSize)<<std::endl;
-  return {offsets,buffer};
+  return {std::move(offsets), std::move(buffer)};
 }
 
 std::vector<char> RootBatchEventsOutputer::compressBuffer(std::vector<char> const& iBuffer) const {
-  return pds::compressBuffer(0, 0, compression_, compressionLevel_, iBuffer);
+  std::vector<char> cBuffer = bufferPool_.get(iBuffer.size()+iBuffer.size()/128+64);
+  pds::compressBuffer(0, 0, compression_, compressionLevel_, iBuffer, cBuffer);
+  return cBuffer;
 }
 
 namespace {
@@ -314,6 +345,12 @@ namespace {
         return {};
       }
 
+      bool specializedSerializers = params.get<bool>("specializedSerializers", false);
+      if(specializedSerializers and *serialization != pds::Serialization::kRootUnrolled) {
+        std::cout <<"specializedSerializers can only be used with the Unrolled serialization"<<std::endl;
+        return {};
+      }
+
       auto treeMaxVirtualSize =  params.get<int>("treeMaxVirtualSize", -1);
       auto autoFlush = params.get<int>("autoFlush", -1);
 
@@ -322,7 +359,7 @@ namespace {
 
       auto batchSize = params.get<int>("batchSize",1);
       
-      return std::make_unique<RootBatchEventsOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel, batchSize);
+      return std::make_unique<RootBatchEventsOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization, specializedSerializers, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel, batchSize);
     }
     
   };
@@ -2,6 +2,8 @@
 #include "OutputerFactory.h"
 #include "ConfigurationParameters.h"
 #include "UnrolledSerializerWrapper.h"
+#include "SpecializedSerializerWrapper.h"
+#include "common_unrolling.h"
 #include "SerializerWrapper.h"
 #include "summarize_serializers.h"
 #include "lz4.h"
@@ -14,13 +16,14 @@ using namespace cce::tf;
 using namespace cce::tf::pds;
 
 RootEventOutputer::RootEventOutputer(std::string const& iFileName, unsigned int iNLanes, Compression iCompression, int iCompressionLevel, 
-                                     Serialization iSerialization, int autoFlush, int maxVirtualSize,
+                                     Serialization iSerialization, bool iSpecializedSerializers, int autoFlush, int maxVirtualSize,
                                      std::string const& iTFileCompression, int iTFileCompressionLevel): 
   file_(iFileName.c_str(), "recreate", "", iTFileCompressionLevel),
   serializers_{std::size_t(iNLanes)},
   compression_{iCompression},
   compressionLevel_{iCompressionLevel},
   serialization_{iSerialization},
+  specializedSerializers_{iSpecializedSerializers},
   serialTime_{std::chrono::microseconds::zero()},
   parallelTime_{0}
   {
@@ -68,8 +71,18 @@ void RootEventOutputer::setupForLane(unsigned int iLaneIndex, std::vector<DataPr
   case Serialization::kRoot:
     {   s = SerializeStrategy::make<SerializeProxy<SerializerWrapper>>(); break; }
   case Serialization::kRootUnrolled:
-    {   s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>(); break; }
+    {
+      if(specializedSerializers_) {
+        s = SerializeStrategy::make<SerializeProxy<SpecializedSerializerWrapper>>();
+      } else {
+        s = SerializeStrategy::make<SerializeProxy<UnrolledSerializerWrapper>>();
+      }
+      break;
+    }
+  case Serialization::kRaw:
+    {   s = SerializeStrategy::make<SerializeProxy<RawSerializerWrapper>>(); break; }
   }
+  prebuildWriteActionSequences(serialization_, iDPs);
   s.reserve(iDPs.size());
   offsetsAndBlob_.first.resize(iDPs.size()+1,0);
   for(auto const& dp: iDPs) {
@@ -104,6 +117,10 @@ void RootEventOutputer::outputAsync(unsigned int iLaneIndex, EventIdentifier con
 void RootEventOutputer::printSummary() const  {
   std::cout <<"RootEventOutputer\n  total serial time at end event: "<<serialTime_.count()<<"us\n"
     "  total parallel time at end event: "<<parallelTime_.load()<<"us\n";
+  std::cout <<"  buffer pool allocations: "<<bufferPool_.allocations()<<" reuses: "<<bufferPool_.reuses()<<"\n";
+  if(specializedSerializers_) {
+    std::cout <<"  specialized serializers in use: "<<specialized::nInUse().load()<<"\n";
+  }
 
   auto start = std::chrono::high_resolution_clock::now();
   file_.Write();
@@ -128,6 +145,8 @@ void RootEventOutputer::output(EventIdentifier const& iEventID, SerializeStrateg
   
   eventID_ = iEventID;
   offsetsAndBlob_.first = std::move(iOffsets);
+  //the previous event's buffer is no longer needed by the TTree
+  bufferPool_.giveBack(std::move(offsetsAndBlob_.second));
   offsetsAndBlob_.second = std::move(iBuffer);
   //std::cout <<"Event "<<eventID_.run<<" "<<eventID_.lumi<<" "<<eventID_.event<<std::endl;
   //std::cout <<"buffer size "<<eventBlob_.size();
@@ -160,6 +179,16 @@ void RootEventOutputer::writeMetaData(SerializeStrategy const& iSerializers) {
   meta->Branch("DataProducts",&typeAndNames, 0, 0);
   meta->Branch("objectSerializationUsed",&objectSerializationUsed);
   meta->Branch("compressionAlgorithm",&compression,0,0);
+  ULong64_t layoutFingerprint = 0;
+  if(serialization_ == Serialization::kRaw) {
+    std::vector<std::string> classNames;
+    classNames.reserve(typeAndNames.size());
+    for(auto const& tn: typeAndNames) {
+      classNames.push_back(tn.first);
+    }
+    layoutFingerprint = unrolling::rawLayoutFingerprint(classNames);
+    meta->Branch("layoutFingerprint",&layoutFingerprint);
+  }
 
   meta->Fill();
 
@@ -178,7 +207,8 @@ std::pair<std::vector<uint32_t>, std::vector<char>> RootEventOutputer::writeData
   offsets.push_back(bufferSize);
 
   //initialize with 0
-  std::vector<char> buffer(bufferSize, 0);
+  std::vector<char> buffer = bufferPool_.get(bufferSize);
+  buffer.resize(bufferSize, 0);
   
   {
     uint32_t index = 0;
@@ -191,14 +221,17 @@ std::pair<std::vector<uint32_t>, std::vector<char>> RootEventOutputer::writeData
   }
 
   auto cBuffer  = compressBuffer(buffer);
+  bufferPool_.giveBack(std::move(buffer));
 
   //std::cout <<"compressed "<<cSize<<" uncompressed "<<buffer.size()<<std::endl;
   //std::cout <<"compressed "<<(buffer.size())/float(cSize)<<std::endl;
-  return {offsets,cBuffer};
+  return {std::move(offsets), std::move(cBuffer)};
 }
 
 std::vector<char> RootEventOutputer::compressBuffer(std::vector<char> const& iBuffer) const {
-  return pds::compressBuffer(0, 0, compression_, compressionLevel_, iBuffer);
+  std::vector<char> cBuffer = bufferPool_.get(iBuffer.size()+iBuffer.size()/128+64);
+  pds::compressBuffer(0, 0, compression_, compressionLevel_, iBuffer, cBuffer);
+  return cBuffer;
 }
 
 namespace {
@@ -232,13 +265,19 @@ namespace {
         return {};
       }
 
+      bool specializedSerializers = params.get<bool>("specializedSerializers", false);
+      if(specializedSerializers and *serialization != pds::Serialization::kRootUnrolled) {
+        std::cout <<"specializedSerializers can only be used with the Unrolled serialization"<<std::endl;
+        return {};
+      }
+
       auto treeMaxVirtualSize =  params.get<int>("treeMaxVirtualSize", -1);
       auto autoFlush = params.get<int>("autoFlush", -1);
 
       auto fileLevelCompression = params.get<std::string>("tfileCompressionAlgorithm", "");
       auto fileLevelCompressionLevel = params.get<int>("tfileCompressionLevel",0);
       
-      return std::make_unique<RootEventOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel);
+      return std::make_unique<RootEventOutputer>(*fileName,iNLanes, *compression, compressionLevel, *serialization, specializedSerializers, autoFlush, treeMaxVirtualSize, fileLevelCompression, fileLevelCompressionLevel);
     }
     
   };
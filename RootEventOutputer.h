@@ -13,6 +13,7 @@
 #include "SerializeStrategy.h"
 #include "DataProductRetriever.h"
 #include "pds_writer.h"
+#include "BufferPool.h"
 
 #include "SerialTaskQueue.h"
 
@@ -20,7 +21,7 @@ namespace cce::tf {
 class RootEventOutputer :public OutputerBase {
  public:
   RootEventOutputer(std::string const& iFileName, unsigned int iNLanes, pds::Compression iCompression, int iCompressionLevel, 
-                    pds::Serialization iSerialization, int autoFlush, int maxVirtualSize,
+                    pds::Serialization iSerialization, bool iSpecializedSerializers, int autoFlush, int maxVirtualSize,
                     std::string const& iTFileCompression, int iTFileCompressionLevel);
  ~RootEventOutputer();
 
@@ -53,6 +54,8 @@ private:
   pds::Compression compression_;
   int compressionLevel_;
   pds::Serialization serialization_;
+  bool specializedSerializers_;
+  mutable BufferPool<char> bufferPool_;
   mutable std::chrono::microseconds serialTime_;
   mutable std::atomic<std::chrono::microseconds::rep> parallelTime_;
 };
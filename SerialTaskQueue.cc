@@ -12,6 +12,10 @@
 //
 
 // system include files
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <algorithm>
 
 // user include files
 #include "SerialTaskQueue.h"
@@ -21,24 +25,85 @@
 //
 using namespace cce::tf;
 
+#if defined(CCE_TF_COMBINING_SERIAL_TASK_QUEUE)
+SerialTaskQueue::Mode SerialTaskQueue::s_defaultMode = SerialTaskQueue::Mode::kCombining;
+#else
+SerialTaskQueue::Mode SerialTaskQueue::s_defaultMode = SerialTaskQueue::Mode::kSpawn;
+#endif
+
+std::atomic<bool> SerialTaskQueue::s_measureOccupancy{false};
+
+namespace {
+  struct QueueRegistry {
+    std::mutex mutex_;
+    std::vector<SerialTaskQueue*> queues_;
+  };
+  QueueRegistry& queueRegistry() {
+    static QueueRegistry s_registry;
+    return s_registry;
+  }
+}
+
+void SerialTaskQueue::registerQueue() {
+  auto& r = queueRegistry();
+  std::lock_guard<std::mutex> guard(r.mutex_);
+  r.queues_.push_back(this);
+}
+
+std::chrono::nanoseconds SerialTaskQueue::takeMaxBusyTime() {
+  long long maxBusy = 0;
+  auto& r = queueRegistry();
+  std::lock_guard<std::mutex> guard(r.mutex_);
+  for(auto q: r.queues_) {
+    maxBusy = std::max(maxBusy, q->m_busyNanoseconds.exchange(0));
+  }
+  return std::chrono::nanoseconds(maxBusy);
+}
+
+void SerialTaskQueue::run(TaskBase& iTask) {
+  //a task from another queue may have pushed to this one while the queue was idle
+  bool wasRunningTask = s_runningTask;
+  s_runningTask = true;
+  if(not s_measureOccupancy.load(std::memory_order_relaxed)) {
+    iTask.execute();
+  } else {
+    auto start = std::chrono::steady_clock::now();
+    iTask.execute();
+    m_busyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  }
+  s_runningTask = wasRunningTask;
+}
+
 SerialTaskQueue::~SerialTaskQueue() {
   //be certain all tasks have completed
-  bool isEmpty = m_tasks.empty();
+  bool isEmpty = empty();
   bool isTaskChosen = m_taskChosen;
   if ((not isEmpty and not isPaused()) or isTaskChosen) {
     tbb::task_group g;
-    push(g, []() { return; });
+    push(g, []() {});
     g.wait();
+    //in the kCombining mode the task may be run by a thread working for another task_group
+    // so wait until that thread has released the queue
+    while(m_taskChosen.load() or (not empty() and not isPaused())) {
+      std::this_thread::yield();
+    }
   }
+  auto& r = queueRegistry();
+  std::lock_guard<std::mutex> guard(r.mutex_);
+  r.queues_.erase(std::find(r.queues_.begin(), r.queues_.end(), this));
 }
 
 void SerialTaskQueue::spawn(TaskBase& iTask) {
   auto pTask = &iTask;
   iTask.group()->run([pTask, this]() {
+      if(m_mode == Mode::kCombining) {
+        runCombined(pTask);
+        return;
+      }
       TaskBase* t = pTask;
       auto g = pTask->group();
       do {
-      	t->execute();
+      	run(*t);
 	delete t;
 	t = finishedTask();
 	if(t and t->group() != g) {
@@ -63,19 +128,103 @@ bool SerialTaskQueue::resume() {
 void SerialTaskQueue::pushTask(TaskBase* iTask) {
   auto* t = pushAndGetNextTask(iTask);
   if (nullptr != t) {
-    spawn(*t);
+    if(m_mode == Mode::kCombining) {
+      //the queue was idle so run the task now instead of waiting for a new TBB task to start
+      runCombined(t);
+    } else {
+      spawn(*t);
+    }
   }
 }
 
 SerialTaskQueue::TaskBase* SerialTaskQueue::pushAndGetNextTask(TaskBase* iTask) {
   TaskBase* returnValue{nullptr};
   if(nullptr != iTask) {
-      m_tasks.push(iTask);
+      if(m_mode == Mode::kCombining) {
+        enqueue(iTask);
+      } else {
+        m_tasks.push(iTask);
+      }
       returnValue = pickNextTask();
     }
   return returnValue;
 }
 
+void SerialTaskQueue::runCombined(TaskBase* iTask) {
+  TaskBase* t = iTask;
+  unsigned int nRun = 0;
+  do {
+    run(*t);
+    delete t;
+    t = nullptr;
+    if(++nRun == kMaxCombined) {
+      //let another thread continue so this one can return to its own work
+      t = finishedTask();
+      if(t) {
+        spawn(*t);
+      }
+      return;
+    }
+    //keep m_taskChosen while there is more to do
+    if(0 != m_pauseCount or not dequeue(t)) {
+      t = finishedTask();
+    }
+  } while(t != nullptr);
+}
+
+bool SerialTaskQueue::empty() const {
+  if(m_mode == Mode::kCombining) {
+    //the stub is only the last entry once every task has been dequeued
+    return m_head.load() == &m_stub;
+  }
+  return m_tasks.empty();
+}
+
+bool SerialTaskQueue::tryPop(TaskBase*& oTask) {
+  if(m_mode == Mode::kCombining) {
+    return dequeue(oTask);
+  }
+  return m_tasks.try_pop(oTask);
+}
+
+void SerialTaskQueue::enqueue(TaskBase* iTask) {
+  iTask->m_next.store(nullptr, std::memory_order_relaxed);
+  auto previous = m_head.exchange(iTask, std::memory_order_acq_rel);
+  //until this store the consumer can not reach iTask, the producer then finds it with pickNextTask
+  previous->m_next.store(iTask, std::memory_order_release);
+}
+
+bool SerialTaskQueue::dequeue(TaskBase*& oTask) {
+  TaskBase* tail = m_tail;
+  TaskBase* next = tail->m_next.load(std::memory_order_acquire);
+  if(tail == &m_stub) {
+    if(nullptr == next) {
+      return false;
+    }
+    m_tail = next;
+    tail = next;
+    next = next->m_next.load(std::memory_order_acquire);
+  }
+  if(nullptr != next) {
+    m_tail = next;
+    oTask = tail;
+    return true;
+  }
+  if(tail != m_head.load(std::memory_order_acquire)) {
+    //a producer is between its exchange and its store
+    return false;
+  }
+  //tail is the last task, put the stub behind it so it can be removed
+  enqueue(&m_stub);
+  next = tail->m_next.load(std::memory_order_acquire);
+  if(nullptr != next) {
+    m_tail = next;
+    oTask = tail;
+    return true;
+  }
+  return false;
+}
+
 SerialTaskQueue::TaskBase* SerialTaskQueue::finishedTask() {
   m_taskChosen.store(false);
   return pickNextTask();
@@ -85,15 +234,15 @@ SerialTaskQueue::TaskBase* SerialTaskQueue::pickNextTask() {
   bool expect = false;
   if(0 == m_pauseCount and m_taskChosen.compare_exchange_strong(expect, true)) {
       TaskBase* t = nullptr;
-      if(m_tasks.try_pop(t)) { return t; }
+      if(tryPop(t)) { return t; }
       //no task was actually pulled
       m_taskChosen.store(false);
 
       //was a new entry added after we called 'try_pop' but before we did the clear?
       expect = false;
-      if (not m_tasks.empty() and m_taskChosen.compare_exchange_strong(expect, true)) {
+      if (not empty() and m_taskChosen.compare_exchange_strong(expect, true)) {
         t = nullptr;
-        if (m_tasks.try_pop(t)) {
+        if (tryPop(t)) {
           return t;
         }
         //no task was still pulled since a different thread beat us to it
@@ -45,6 +45,14 @@
    });
  }
 \endcode
+
+ The queue has two modes. In the kSpawn mode the tasks are held in a tbb::concurrent_queue and
+ each task which becomes ready is started by spawning a new TBB task. In the kCombining mode the
+ tasks are held in an intrusive lock-free multiple producer, single consumer list and the thread
+ which pushes a task while the queue is idle runs it immediately, followed by any task pushed in
+ the meantime. The tasks then run on that thread back-to-back, whatever their task_group. The
+ mode used by newly constructed queues can be set with setDefaultMode, its initial value is
+ kCombining if the code was compiled with CCE_TF_COMBINING_SERIAL_TASK_QUEUE defined.
 */
 //
 // Original Author:  Chris Jones
@@ -55,6 +63,7 @@
 // system include files
 #include <atomic>
 #include <cassert>
+#include <chrono>
 
 #include "tbb/task_group.h"
 #include "tbb/concurrent_queue.h"
@@ -65,16 +74,37 @@
 namespace cce::tf {
 class SerialTaskQueue {
   public:
-    SerialTaskQueue() : m_taskChosen(false), m_pauseCount{0} {}
+    enum class Mode { kSpawn, kCombining };
+
+    SerialTaskQueue() : SerialTaskQueue(defaultMode()) {}
+    explicit SerialTaskQueue(Mode iMode) : m_taskChosen(false), m_pauseCount{0}, m_mode{iMode}, m_head{&m_stub}, m_tail{&m_stub} {
+      registerQueue();
+    }
 
     SerialTaskQueue(SerialTaskQueue&& iOther)
         : m_tasks(std::move(iOther.m_tasks)),
           m_taskChosen(iOther.m_taskChosen.exchange(false)),
-          m_pauseCount(iOther.m_pauseCount.exchange(0)) {
-      assert(m_tasks.empty() and m_taskChosen == false);
+          m_pauseCount(iOther.m_pauseCount.exchange(0)),
+          m_mode{iOther.m_mode},
+          m_head{&m_stub},
+          m_tail{&m_stub} {
+      assert(m_tasks.empty() and m_taskChosen == false and iOther.m_head.load() == &iOther.m_stub);
+      registerQueue();
     }
     ~SerialTaskQueue();
 
+    /// Sets the mode used by queues constructed afterwards
+    static void setDefaultMode(Mode iMode) { s_defaultMode = iMode; }
+    static Mode defaultMode() { return s_defaultMode; }
+
+    /// Turns on timing how long each queue spends running tasks
+    static void setMeasureOccupancy(bool iMeasure) { s_measureOccupancy = iMeasure; }
+    /// Returns the largest time any existing queue spent running tasks since the previous call
+    static std::chrono::nanoseconds takeMaxBusyTime();
+
+    /// Returns true if the calling thread is presently running a task taken from a SerialTaskQueue
+    static bool isRunningTask() { return s_runningTask; }
+
     // ---------- const member functions ---------------------
     /// Checks to see if the queue has been paused.
     /**\return true if the queue is paused
@@ -82,6 +112,8 @@ class SerialTaskQueue {
        */
     bool isPaused() const { return m_pauseCount.load() != 0; }
 
+    Mode mode() const { return m_mode; }
+
     // ---------- member functions ---------------------------
     /// Pauses processing of additional tasks from the queue.
     /**
@@ -124,11 +156,23 @@ class SerialTaskQueue {
 
       tbb::task_group* group() { return m_group;}
       virtual void execute() = 0 ;
+    public:
+      virtual ~TaskBase() = default;
     protected:
       explicit TaskBase(tbb::task_group* iGroup) : m_group(iGroup)  {}
 
     private:
       tbb::task_group* m_group;
+      //link used by the kCombining mode
+      std::atomic<TaskBase*> m_next{nullptr};
+    };
+
+    //always kept in the kCombining list so that list is never empty
+    class StubTask : public TaskBase {
+    public:
+      StubTask() : TaskBase(nullptr) {}
+    private:
+      void execute() final {}
     };
 
     template <typename T>
@@ -152,10 +196,38 @@ class SerialTaskQueue {
 
     void spawn(TaskBase&) ;
 
+    bool empty() const;
+    //must only be called while holding m_taskChosen
+    bool tryPop(TaskBase*&);
+
+    //kCombining list operations
+    void enqueue(TaskBase*);
+    bool dequeue(TaskBase*&);
+    void runCombined(TaskBase*);
+
+    void run(TaskBase&);
+    void registerQueue();
+
+    //bounds the time a pushing thread spends running other producers' tasks
+    static constexpr unsigned int kMaxCombined = 64;
+    static Mode s_defaultMode;
+    static std::atomic<bool> s_measureOccupancy;
+    static inline thread_local bool s_runningTask = false;
+
     // ---------- member data --------------------------------
     tbb::concurrent_queue<TaskBase*> m_tasks;
     std::atomic<bool> m_taskChosen;
     std::atomic<unsigned long> m_pauseCount;
+    Mode m_mode;
+
+    //the kCombining list, producers exchange m_head while only the thread holding
+    // m_taskChosen moves m_tail
+    StubTask m_stub;
+    std::atomic<TaskBase*> m_head;
+    TaskBase* m_tail;
+
+    //only updated if s_measureOccupancy is set
+    std::atomic<long long> m_busyNanoseconds{0};
 };
 
 template <typename T>
@@ -1,3 +1,16 @@
 #include "SerializeStrategy.h"
+#include "common_unrolling.h"
 
 cce::tf::SerializeProxyBase::~SerializeProxyBase() = default;
+
+void cce::tf::prebuildWriteActionSequences(pds::Serialization iSerialization, std::vector<DataProductRetriever> const& iDPs) {
+  if(iSerialization == pds::Serialization::kRoot) {
+    return;
+  }
+  std::vector<TClass*> classes;
+  classes.reserve(iDPs.size());
+  for(auto const& dp: iDPs) {
+    classes.push_back(dp.classType());
+  }
+  unrolling::prebuildWriteActionSequences(classes);
+}
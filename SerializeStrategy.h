@@ -10,6 +10,9 @@
 
 #include "TaskHolder.h"
 #include "ProxyVector.h"
+#include "BlobView.h"
+#include "DataProductRetriever.h"
+#include "pds_common.h"
 
 namespace cce::tf {
 class SerializeProxyBase {
@@ -19,11 +22,12 @@ class SerializeProxyBase {
  virtual ~SerializeProxyBase();
 
  virtual void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) = 0;
- virtual std::vector<char> const& blob() const = 0;
+ virtual BlobView blob() const = 0;
 
  virtual std::string_view  name() const = 0;
  virtual char const* className() const = 0;
  virtual std::chrono::microseconds accumulatedTime() const = 0;
+ virtual unsigned long long bufferReallocations() const = 0;
 };
 
 
@@ -36,11 +40,12 @@ class SerializeProxy final : public SerializeProxyBase {
   void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) {
     wrapper_.doWorkAsync(iGroup, iAddress, iCallback);
   }
-  std::vector<char> const& blob() const { return wrapper_.blob(); }
+  BlobView blob() const { return wrapper_.blob(); }
 
   std::string_view  name() const { return wrapper_.name();}
   char const* className() const { return wrapper_.className();}
   std::chrono::microseconds accumulatedTime() const {return wrapper_.accumulatedTime();}
+  unsigned long long bufferReallocations() const {return wrapper_.bufferReallocations();}
  private:
   WRAPPER wrapper_;
 };
@@ -48,5 +53,9 @@ class SerializeProxy final : public SerializeProxyBase {
 
  using SerializeStrategy = ProxyVector<SerializeProxyBase, std::string_view, TClass*>;
 
+ //builds the action sequences used by the unrolled serializations before the serializers of
+ // the first lane are made so the serializers of the other lanes reuse them
+ void prebuildWriteActionSequences(pds::Serialization, std::vector<DataProductRetriever> const&);
+
 }
 #endif
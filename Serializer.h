@@ -4,28 +4,34 @@
 #include <vector>
 #include "TBufferFile.h"
 #include "TClass.h"
+#include "BlobView.h"
+#include "BufferSizer.h"
 
 namespace cce::tf {
 class Serializer {
 public:
-  Serializer() : bufferFile_{TBuffer::kWrite} {}
+  explicit Serializer(BufferSizer iSizer = BufferSizer{}) : bufferFile_{TBuffer::kWrite}, sizer_{std::move(iSizer)} {}
 
-  Serializer(Serializer&& ):
-    bufferFile_{TBuffer::kWrite} {}
+  Serializer(Serializer&& iOther):
+    bufferFile_{TBuffer::kWrite}, sizer_{std::move(iOther.sizer_)} {}
 
-  Serializer(Serializer const&):
-    bufferFile_{TBuffer::kWrite} {}
+  Serializer(Serializer const& iOther):
+    bufferFile_{TBuffer::kWrite}, sizer_{iOther.sizer_} {}
 
-  std::vector<char> serialize(void const* address, TClass* tClass) {
+  //The returned blob refers to the internal buffer and is only valid until the next call
+  BlobView serialize(void const* address, TClass* tClass) {
     bufferFile_.Reset();
+    sizer_.presize(bufferFile_);
     tClass->WriteBuffer(bufferFile_, const_cast<void*>(address));
-    //The blob contains the serialized data product
-    std::vector<char> blob(bufferFile_.Buffer(), bufferFile_.Buffer()+bufferFile_.Length());
-    return blob;
+    sizer_.update(bufferFile_);
+    return BlobView(bufferFile_.Buffer(), bufferFile_.Length());
   }
 
+  BufferSizer const& sizer() const { return sizer_; }
+
 private:
   TBufferFile bufferFile_;
+  BufferSizer sizer_;
 };
 }
 #endif
@@ -8,13 +8,14 @@
 #include "tbb/task_group.h"
 #include "Serializer.h"
 #include "TaskHolder.h"
+#include "BlobView.h"
 
 
 namespace cce::tf {
 class SerializerWrapper {
 public:
  SerializerWrapper(std::string_view iName,  TClass* tClass):
-  name_{iName}, class_(tClass), serializer_{},
+  name_{iName}, class_(tClass), serializer_{BufferSizer{BufferSizeStatistics::forProduct(iName)}},
   accumulatedTime_{std::chrono::microseconds::zero()} {}
 
   void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) {
@@ -27,13 +28,14 @@ public:
 	const_cast<TaskHolder&>(callback).doneWaiting();
       });
   }
-  std::vector<char> const& blob() const {return blob_;}
+  BlobView blob() const {return blob_;}
 
   std::string_view  name() const {return name_;}
   char const* className() const { return class_->GetName(); }
   std::chrono::microseconds accumulatedTime() const { return accumulatedTime_;}
+  unsigned long long bufferReallocations() const { return serializer_.sizer().reallocations(); }
 private:
-  std::vector<char> blob_;
+  BlobView blob_;
   std::string_view name_;
   TClass* class_;
   Serializer serializer_;
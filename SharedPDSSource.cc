@@ -1,43 +1,109 @@
 #include "SharedPDSSource.h"
 #include "SourceFactory.h"
-#include "Deserializer.h"
-#include "UnrolledDeserializer.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "TClass.h"
 
 using namespace cce::tf;
 
-SharedPDSSource::SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName) :
+SharedPDSSource::SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iName, unsigned long long iFirstEvent, bool iUsePread,
+                                 unsigned int iPrefetchDepth) :
                  SharedSourceBase(iNEvents),
                  file_{iName, std::ios_base::binary},
+  firstEvent_{iFirstEvent},
+  nextFileEventIndex_{0},
+  usePread_{iUsePread},
+  prefetchDepth_{iPrefetchDepth},
   readTime_{std::chrono::microseconds::zero()}
 {
   pds::Serialization serialization;
-  auto productInfo = readFileHeader(file_, compression_, serialization);
+  std::vector<char> dictionary;
+  uint32_t flags;
+  uint64_t layoutFingerprint;
+  auto productInfo = readFileHeader(file_, compression_, serialization, dictionary, flags, layoutFingerprint);
+  checkLayoutFingerprint(serialization, productInfo, layoutFingerprint);
+  dictionary_ = pds::makeDecompressionDictionary(dictionary);
+  perProductCompression_ = flags & pds::kFileHasPerProductCompression;
+  if(flags & pds::kFileHasProductReferences) {
+    referenceResolver_ = std::make_unique<pds::ProductReferenceResolver>(iName, compression_, dictionary_.get(), productInfo.size());
+  }
+  columnarBatches_ = flags & pds::kFileHasColumnarBatches;
+  if(columnarBatches_ and (iUsePread or iPrefetchDepth > 0)) {
+    throw std::runtime_error("the pread and prefetch options can not be used with columnar batches");
+  }
+  eventIndex_ = pds::readEventIndex(file_);
+  if(eventIndex_.empty() and not columnarBatches_) {
+    //without an index the only option is to walk the file
+    while(nextFileEventIndex_ < firstEvent_ and pds::skipToNextEvent(file_)) {
+      ++nextFileEventIndex_;
+    }
+  }
+  if(iUsePread or iPrefetchDepth > 0) {
+    fileDescriptor_ = open(iName.c_str(), O_RDONLY);
+    if(fileDescriptor_ < 0) {
+      throw std::runtime_error("unable to open file "+iName);
+    }
+    if(not file_) {
+      //walking to the first event reached the end of the file
+      file_.clear();
+      file_.seekg(0, std::ios_base::end);
+    }
+    nextOffset_ = file_.tellg();
+    if(iPrefetchDepth > 0 and not eventIndex_.empty()) {
+      recordRequested_.resize(eventIndex_.size(), false);
+      nextFileEventIndex_ = firstEvent_;
+    }
+  }
 
+  deserializers_ = pds::makeDeserializeStrategy(serialization, productInfo, iNLanes);
   laneInfos_.reserve(iNLanes);
   for(unsigned int i = 0; i< iNLanes; ++i) {
-    DeserializeStrategy strategy;
-    switch(serialization) {
-    case pds::Serialization::kRoot: { 
-      strategy = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
+    laneInfos_.emplace_back(productInfo);
+  }
+  if(columnarBatches_ and not eventIndex_.empty()) {
+    positionsInBatch_.resize(eventIndex_.size(), 0);
+    for(size_t i = 1; i < eventIndex_.size(); ++i) {
+      if(eventIndex_[i].offset == eventIndex_[i-1].offset) {
+        positionsInBatch_[i] = positionsInBatch_[i-1]+1;
+      }
     }
-    case pds::Serialization::kRootUnrolled: {
-      strategy = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
+  }
+  if(columnarBatches_ and eventIndex_.empty()) {
+    unsigned long long skipped = 0;
+    while(skipped < firstEvent_ and readNextColumnarBatch()) {
+      nextInBatch_ = std::min<unsigned long long>(presentBatch_->eventIDs_.size(), firstEvent_ - skipped);
+      skipped += nextInBatch_;
     }
+  }
+  if(perProductCompression_ or columnarBatches_) {
+    unsigned int lane = 0;
+    for(auto& laneInfo: laneInfos_) {
+      laneInfo.delayedRetriever_.setSource(this, lane++);
+      laneInfo.compressedProducts_.resize(productInfo.size());
+      laneInfo.productDecompressTimes_.resize(productInfo.size(), std::chrono::microseconds::zero());
+      laneInfo.productDeserializeTimes_.resize(productInfo.size(), std::chrono::microseconds::zero());
     }
-    laneInfos_.emplace_back(productInfo, std::move(strategy));
   }
 }
 
-SharedPDSSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy deserialize):
-  deserializers_{std::move(deserialize)},
+SharedPDSSource::~SharedPDSSource() {
+  if(fileDescriptor_ >= 0) {
+    close(fileDescriptor_);
+  }
+}
+
+SharedPDSSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo):
+  readTime_{std::chrono::microseconds::zero()},
   decompressTime_{std::chrono::microseconds::zero()},
   deserializeTime_{std::chrono::microseconds::zero()}
 {
   dataProducts_.reserve(productInfo.size());
   dataBuffers_.resize(productInfo.size(), nullptr);
-  deserializers_.reserve(productInfo.size());
   size_t index =0;
   for(auto const& pi : productInfo) {
     
@@ -49,7 +115,6 @@ SharedPDSSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& product
                                pi.name(),
                                cls,
 			       &delayedRetriever_);
-    deserializers_.emplace_back(cls);
     ++index;
   }
 }
@@ -75,47 +140,392 @@ EventIdentifier SharedPDSSource::eventIdentifier(unsigned int iLane, long iEvent
 }
 
 void SharedPDSSource::readEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder iTask) {
-  queue_.push(*iTask.group(), [iLane, optTask = std::move(iTask), this]() mutable {
+  if(usePread_) {
+    preadEventAsync(iLane, iEventIndex, std::move(iTask));
+    return;
+  }
+  if(prefetchDepth_ > 0) {
+    prefetchEventAsync(iLane, iEventIndex, std::move(iTask));
+    return;
+  }
+  queue_.push(*iTask.group(), [iLane, optTask = std::move(iTask), this, iEventIndex]() mutable {
       auto start = std::chrono::high_resolution_clock::now();
-      std::vector<uint32_t> buffer;
-      
-      if(pds::readCompressedEventBuffer(file_, this->laneInfos_[iLane].eventID_, buffer)) {
+      auto& laneInfo = this->laneInfos_[iLane];
+      if(columnarBatches_) {
+        if(setupColumnarEvent(laneInfo, iEventIndex)) {
+          //data products are only decompressed when requested
+          optTask.releaseToTaskHolder();
+        }
+        readTime_ +=std::chrono::duration_cast<decltype(readTime_)>(std::chrono::high_resolution_clock::now() - start);
+        return;
+      }
+      auto& buffer = laneInfo.compressedBuffer_;
+
+      bool haveEvent = true;
+      if(not eventIndex_.empty()) {
+        auto fileEventIndex = firstEvent_ + iEventIndex;
+        if(fileEventIndex >= eventIndex_.size()) {
+          haveEvent = false;
+        } else if(fileEventIndex != nextFileEventIndex_) {
+          file_.seekg(eventIndex_[fileEventIndex].offset);
+          nextFileEventIndex_ = fileEventIndex;
+        }
+      }
+      if(haveEvent and pds::readCompressedEventBuffer(file_, laneInfo.eventID_, buffer)) {
+        ++nextFileEventIndex_;
         //last entry in buffer is just a crosscheck on its size
         buffer.pop_back();
         auto group = optTask.group();
-        group->run([this, buffer=std::move(buffer), task = optTask.releaseToTaskHolder(), iLane]() {
-            auto& laneInfo = this->laneInfos_[iLane];
-
-            auto start = std::chrono::high_resolution_clock::now();
-            std::vector<uint32_t> uBuffer = pds::uncompressEventBuffer(this->compression_, buffer);
-            laneInfo.decompressTime_ += 
-              std::chrono::duration_cast<decltype(laneInfo.decompressTime_)>(std::chrono::high_resolution_clock::now() - start);
-            
-            start = std::chrono::high_resolution_clock::now();
-            pds::deserializeDataProducts(uBuffer.begin(), uBuffer.end(), laneInfo.dataProducts_, laneInfo.deserializers_);
-            laneInfo.deserializeTime_ += 
-              std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
+        group->run([this, task = optTask.releaseToTaskHolder(), iLane]() {
+            decompressAndDeserialize(iLane);
           });
       }
       readTime_ +=std::chrono::duration_cast<decltype(readTime_)>(std::chrono::high_resolution_clock::now() - start);
     });
 }
 
+void SharedPDSSource::prefetchEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder iTask) {
+  //the queue only does the bookkeeping, the records are read by other tasks
+  queue_.push(*iTask.group(), [iLane, optTask = std::move(iTask), this, iEventIndex]() mutable {
+      auto start = std::chrono::high_resolution_clock::now();
+      auto group = optTask.group();
+      auto itFound = findPrefetched(iEventIndex);
+      if(itFound != prefetched_.end()) {
+        ++prefetchHits_;
+        if(itFound->ready_) {
+          deliverPrefetched(itFound, iLane, std::move(optTask));
+        } else {
+          //the task finishing the read hands over the record
+          itFound->waitingLane_ = iLane;
+          itFound->waitingTask_.emplace(std::move(optTask));
+        }
+      } else {
+        bool haveEvent = false;
+        uint64_t offset;
+        uint32_t recordSize;
+        auto& laneInfo = this->laneInfos_[iLane];
+        if(eventIndex_.empty()) {
+          //the lanes take the records in file order
+          unsigned long long fileEventIndex;
+          haveEvent = nextRecordToRead(fileEventIndex, offset, recordSize, laneInfo.eventID_);
+        } else {
+          auto fileEventIndex = firstEvent_ + iEventIndex;
+          if(fileEventIndex < eventIndex_.size()) {
+            haveEvent = true;
+            recordRequested_[fileEventIndex] = true;
+            auto const& entry = eventIndex_[fileEventIndex];
+            offset = entry.offset;
+            recordSize = entry.recordSize;
+            laneInfo.eventID_ = entry.eventID;
+          }
+        }
+        if(haveEvent) {
+          ++prefetchMisses_;
+          preadRecordAsync(iLane, offset, recordSize, std::move(optTask));
+        }
+      }
+      //read ahead while the lanes work on their events
+      prefetch(*group);
+      readTime_ +=std::chrono::duration_cast<decltype(readTime_)>(std::chrono::high_resolution_clock::now() - start);
+    });
+}
+
+SharedPDSSource::PrefetchedIterator SharedPDSSource::findPrefetched(long iEventIndex) {
+  if(eventIndex_.empty()) {
+    //without an index the lanes take the records in file order
+    return std::find_if(prefetched_.begin(), prefetched_.end(),
+                        [](auto const& iEvent) { return not iEvent.waitingTask_;});
+  }
+  //lanes may ask for events in a different order than the file order
+  auto fileEventIndex = firstEvent_ + iEventIndex;
+  return std::find_if(prefetched_.begin(), prefetched_.end(),
+                      [fileEventIndex](auto const& iEvent) { return iEvent.fileEventIndex_ == fileEventIndex;});
+}
+
+void SharedPDSSource::deliverPrefetched(PrefetchedIterator iEvent, unsigned int iLane, OptionalTaskHolder iTask) {
+  auto& laneInfo = this->laneInfos_[iLane];
+  laneInfo.eventID_ = iEvent->eventID_;
+  //the lane's previous buffer can be reused for the next read ahead
+  std::swap(laneInfo.compressedBuffer_, iEvent->buffer_);
+  freeBuffers_.push_back(std::move(iEvent->buffer_));
+  prefetched_.erase(iEvent);
+  auto group = iTask.group();
+  group->run([this, task = iTask.releaseToTaskHolder(), iLane]() {
+      decompressAndDeserialize(iLane);
+    });
+}
+
+bool SharedPDSSource::nextRecordToRead(unsigned long long& oFileEventIndex, uint64_t& oOffset, uint32_t& oRecordSize, EventIdentifier& oEventID) {
+  if(reachedEndOfFile_) {
+    return false;
+  }
+  if(eventIndex_.empty()) {
+    if(not pds::preadEventHeader(fileDescriptor_, nextOffset_, oEventID, oRecordSize)) {
+      reachedEndOfFile_ = true;
+      return false;
+    }
+    oOffset = nextOffset_;
+    nextOffset_ += (pds::kEventHeaderSizeInWords+1+oRecordSize+1)*4;
+    oFileEventIndex = nextFileEventIndex_++;
+    return true;
+  }
+  //records a lane already asked for were read for that lane
+  while(nextFileEventIndex_ < eventIndex_.size() and recordRequested_[nextFileEventIndex_]) {
+    ++nextFileEventIndex_;
+  }
+  if(nextFileEventIndex_ >= eventIndex_.size()) {
+    reachedEndOfFile_ = true;
+    return false;
+  }
+  auto const& entry = eventIndex_[nextFileEventIndex_];
+  recordRequested_[nextFileEventIndex_] = true;
+  oOffset = entry.offset;
+  oRecordSize = entry.recordSize;
+  oEventID = entry.eventID;
+  oFileEventIndex = nextFileEventIndex_++;
+  return true;
+}
+
+void SharedPDSSource::prefetch(tbb::task_group& iGroup) {
+  while(prefetched_.size() < prefetchDepth_) {
+    PrefetchedEvent event;
+    if(not nextRecordToRead(event.fileEventIndex_, event.offset_, event.recordSize_, event.eventID_)) {
+      break;
+    }
+    if(not freeBuffers_.empty()) {
+      event.buffer_ = std::move(freeBuffers_.back());
+      freeBuffers_.pop_back();
+    }
+    prefetched_.push_back(std::move(event));
+    auto itEvent = std::prev(prefetched_.end());
+    iGroup.run([this, itEvent, &iGroup]() {
+        auto start = std::chrono::high_resolution_clock::now();
+        pds::preadCompressedEventBuffer(fileDescriptor_, itEvent->offset_, itEvent->recordSize_, itEvent->buffer_);
+        //last entry in buffer is just a crosscheck on its size
+        itEvent->buffer_.pop_back();
+        itEvent->readTime_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+        queue_.push(iGroup, [this, itEvent, &iGroup]() {
+            readTime_ += itEvent->readTime_;
+            itEvent->ready_ = true;
+            if(itEvent->waitingTask_) {
+              deliverPrefetched(itEvent, itEvent->waitingLane_, std::move(*itEvent->waitingTask_));
+              prefetch(iGroup);
+            }
+          });
+      });
+  }
+}
+
+bool SharedPDSSource::readNextColumnarBatch() {
+  auto batch = std::make_shared<ColumnarBatch>();
+  EventIdentifier firstEventID;
+  if(not pds::readCompressedEventBuffer(file_, firstEventID, batch->record_)) {
+    return false;
+  }
+  //last entry in buffer is just a crosscheck on its size
+  batch->record_.pop_back();
+  auto nProducts = numberOfDataProducts();
+  batch->columns_.resize(nProducts);
+  batch->eventIDs_ = pds::readColumnarBatch(batch->record_.data(), batch->record_.size(), batch->columns_);
+  batch->uncompressOnce_ = std::make_unique<std::once_flag[]>(nProducts);
+  batch->uncompressedColumns_.resize(nProducts);
+  presentBatch_ = std::move(batch);
+  nextInBatch_ = 0;
+  return true;
+}
+
+bool SharedPDSSource::setupColumnarEvent(LaneInfo& laneInfo, long iEventIndex) {
+  if(eventIndex_.empty()) {
+    //the events are handed out in file order
+    if(not ((presentBatch_ and nextInBatch_ < presentBatch_->eventIDs_.size()) or readNextColumnarBatch())) {
+      return false;
+    }
+    laneInfo.batch_ = presentBatch_;
+    laneInfo.indexInBatch_ = nextInBatch_++;
+  } else {
+    auto fileEventIndex = firstEvent_ + iEventIndex;
+    if(fileEventIndex >= eventIndex_.size()) {
+      return false;
+    }
+    auto offset = eventIndex_[fileEventIndex].offset;
+    std::shared_ptr<ColumnarBatch> batch;
+    auto itFound = batchesInUse_.find(offset);
+    if(itFound != batchesInUse_.end()) {
+      batch = itFound->second.lock();
+    }
+    if(not batch) {
+      file_.seekg(offset);
+      if(not readNextColumnarBatch()) {
+        return false;
+      }
+      batch = presentBatch_;
+      //forget the batches no lane uses anymore
+      for(auto it = batchesInUse_.begin(); it != batchesInUse_.end();) {
+        it = it->second.expired() ? batchesInUse_.erase(it) : std::next(it);
+      }
+      batchesInUse_[offset] = batch;
+    }
+    laneInfo.batch_ = std::move(batch);
+    laneInfo.indexInBatch_ = positionsInBatch_[fileEventIndex];
+  }
+  laneInfo.eventID_ = laneInfo.batch_->eventIDs_[laneInfo.indexInBatch_];
+  return true;
+}
+
+void SharedPDSSource::preadEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder iTask) {
+  if(not eventIndex_.empty()) {
+    //every lane knows where its event is so no synchronization is needed
+    auto fileEventIndex = firstEvent_ + iEventIndex;
+    if(fileEventIndex >= eventIndex_.size()) {
+      return;
+    }
+    auto const& entry = eventIndex_[fileEventIndex];
+    laneInfos_[iLane].eventID_ = entry.eventID;
+    preadRecordAsync(iLane, entry.offset, entry.recordSize, std::move(iTask));
+    return;
+  }
+  //the queue is only used to find where the next event record starts
+  queue_.push(*iTask.group(), [iLane, optTask = std::move(iTask), this]() mutable {
+      auto start = std::chrono::high_resolution_clock::now();
+      uint32_t recordSize;
+      bool haveEvent = pds::preadEventHeader(fileDescriptor_, nextOffset_, this->laneInfos_[iLane].eventID_, recordSize);
+      auto offset = nextOffset_;
+      if(haveEvent) {
+        nextOffset_ += (pds::kEventHeaderSizeInWords+1+recordSize+1)*4;
+      }
+      readTime_ +=std::chrono::duration_cast<decltype(readTime_)>(std::chrono::high_resolution_clock::now() - start);
+      if(haveEvent) {
+        preadRecordAsync(iLane, offset, recordSize, std::move(optTask));
+      }
+    });
+}
+
+void SharedPDSSource::preadRecordAsync(unsigned int iLane, uint64_t iOffset, uint32_t iRecordSize, OptionalTaskHolder iTask) {
+  auto group = iTask.group();
+  group->run([this, iOffset, iRecordSize, task = iTask.releaseToTaskHolder(), iLane]() {
+      auto& laneInfo = this->laneInfos_[iLane];
+      auto start = std::chrono::high_resolution_clock::now();
+      auto& buffer = laneInfo.compressedBuffer_;
+      pds::preadCompressedEventBuffer(fileDescriptor_, iOffset, iRecordSize, buffer);
+      //last entry in buffer is just a crosscheck on its size
+      buffer.pop_back();
+      laneInfo.readTime_ += 
+        std::chrono::duration_cast<decltype(laneInfo.readTime_)>(std::chrono::high_resolution_clock::now() - start);
+      decompressAndDeserialize(iLane);
+    });
+}
+
+void SharedPDSSource::decompressAndDeserialize(unsigned int iLane) {
+  auto& laneInfo = laneInfos_[iLane];
+  auto const& buffer = laneInfo.compressedBuffer_;
+  if(perProductCompression_) {
+    //the work is deferred until each data product is requested
+    pds::locateCompressedDataProducts(buffer.data(), buffer.size(), laneInfo.compressedProducts_);
+    return;
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  std::vector<uint32_t> uBuffer = pds::uncompressEventBuffer(this->compression_, buffer, dictionary_.get());
+  laneInfo.decompressTime_ += 
+    std::chrono::duration_cast<decltype(laneInfo.decompressTime_)>(std::chrono::high_resolution_clock::now() - start);
+  
+  start = std::chrono::high_resolution_clock::now();
+  pds::deserializeDataProducts(uBuffer.begin(), uBuffer.end(), laneInfo.dataProducts_, deserializers_, iLane);
+  laneInfo.deserializeTime_ += 
+    std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
+}
+
+void SharedPDSDelayedRetriever::getAsync(DataProductRetriever& iDataProduct, int iIndex, TaskHolder iTask) {
+  if(source_) {
+    source_->getProductAsync(lane_, iDataProduct, iIndex, std::move(iTask));
+  }
+}
+
+void SharedPDSSource::getProductAsync(unsigned int iLane, DataProductRetriever& iDataProduct, int iIndex, TaskHolder iTask) {
+  //the lane's compressed buffer is not replaced until all its data products have been used
+  auto group = iTask.group();
+  group->run([this, iLane, iIndex, &iDataProduct, task = std::move(iTask)]() {
+      auto& laneInfo = this->laneInfos_[iLane];
+      if(columnarBatches_) {
+        getProductFromBatch(iLane, iDataProduct, iIndex);
+        return;
+      }
+      auto const& product = laneInfo.compressedProducts_[iIndex];
+      if(product.size == 0) {
+        return;
+      }
+      auto start = std::chrono::high_resolution_clock::now();
+      std::vector<uint32_t> uBuffer;
+      std::shared_ptr<std::vector<uint32_t> const> referenced;
+      if(product.isReference) {
+        referenced = referenceResolver_->uncompressedProduct(iIndex, laneInfo.compressedBuffer_.data()+product.offset);
+      } else {
+        uBuffer = pds::uncompressEventBuffer(this->compression_, laneInfo.compressedBuffer_.data()+product.offset, product.size, dictionary_.get());
+      }
+      auto const& uProduct = referenced ? *referenced : uBuffer;
+      laneInfo.productDecompressTimes_[iIndex] +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+      start = std::chrono::high_resolution_clock::now();
+      auto readSize = deserializers_[iIndex].deserialize(iLane, reinterpret_cast<char const*>(uProduct.data()), uProduct.size()*4, *iDataProduct.address());
+      iDataProduct.setSize(readSize);
+      laneInfo.productDeserializeTimes_[iIndex] +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+    });
+}
+
+void SharedPDSSource::getProductFromBatch(unsigned int iLane, DataProductRetriever& iDataProduct, int iIndex) {
+  auto& laneInfo = laneInfos_[iLane];
+  auto& batch = *laneInfo.batch_;
+  auto const& column = batch.columns_[iIndex];
+  if(column.size == 0) {
+    return;
+  }
+  auto start = std::chrono::high_resolution_clock::now();
+  std::call_once(batch.uncompressOnce_[iIndex], [this, &batch, &column, iIndex]() {
+      batch.uncompressedColumns_[iIndex] = pds::uncompressEventBuffer(this->compression_, batch.record_.data()+column.offset, column.size, dictionary_.get());
+    });
+  laneInfo.productDecompressTimes_[iIndex] +=
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+
+  start = std::chrono::high_resolution_clock::now();
+  auto const& uColumn = batch.uncompressedColumns_[iIndex];
+  //the column starts with the offsets to each event's data product
+  auto const nEvents = batch.eventIDs_.size();
+  auto begin = uColumn[laneInfo.indexInBatch_];
+  auto end = uColumn[laneInfo.indexInBatch_+1];
+  auto readSize = deserializers_[iIndex].deserialize(iLane, reinterpret_cast<char const*>(uColumn.data()+nEvents+1+begin), (end-begin)*4, *iDataProduct.address());
+  iDataProduct.setSize(readSize);
+  laneInfo.productDeserializeTimes_[iIndex] +=
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+}
+
 void SharedPDSSource::printSummary() const {
   std::cout <<"\nSource:\n"
     "   read time: "<<readTime().count()<<"us\n"
     "   decompress time: "<<decompressTime().count()<<"us\n"
-    "   deserialize time: "<<deserializeTime().count()<<"us\n"<<std::endl;
+    "   deserialize time: "<<deserializeTime().count()<<"us\n";
+  if(prefetchDepth_ > 0) {
+    std::cout <<"   prefetch hits: "<<prefetchHits_<<"\n"
+      "   prefetch misses: "<<prefetchMisses_<<"\n";
+  }
+  std::cout<<std::endl;
 };
 
 std::chrono::microseconds SharedPDSSource::readTime() const {
-  return readTime_;
+  auto time = readTime_;
+  for(auto const& l : laneInfos_) {
+    time += l.readTime_;
+  }
+  return time;
 }
 
 std::chrono::microseconds SharedPDSSource::decompressTime() const {
   auto time = std::chrono::microseconds::zero();
   for(auto const& l : laneInfos_) {
     time += l.decompressTime_;
+    for(auto t: l.productDecompressTimes_) {
+      time += t;
+    }
   }
   return time;
 }
@@ -124,6 +534,9 @@ std::chrono::microseconds SharedPDSSource::deserializeTime() const {
   auto time = std::chrono::microseconds::zero();
   for(auto const& l : laneInfos_) {
     time += l.deserializeTime_;
+    for(auto t: l.productDeserializeTimes_) {
+      time += t;
+    }
   }
   return time;
 }
@@ -139,7 +552,14 @@ namespace {
           std::cout <<"no file name given\n";
           return {};
         }
-        return std::make_unique<SharedPDSSource>(iNLanes, iNEvents, *fileName);
+        unsigned int firstEvent = params.get<unsigned int>("firstEvent", 0);
+        bool usePread = params.get<bool>("pread", false);
+        unsigned int prefetch = params.get<unsigned int>("prefetch", 0);
+        if(usePread and prefetch > 0) {
+          std::cout <<"the pread and prefetch options can not be used together\n";
+          return {};
+        }
+        return std::make_unique<SharedPDSSource>(iNLanes, iNEvents, *fileName, firstEvent, usePread, prefetch);
     }
     };
 
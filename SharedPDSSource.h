@@ -6,6 +6,10 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
 
 #include "SharedSourceBase.h"
 #include "DataProductRetriever.h"
@@ -16,16 +20,28 @@
 
 
 namespace cce::tf {
+  class SharedPDSSource;
+
+  //Only does work if the file compressed each data product separately. In that case the
+  // product is decompressed and deserialized when it is requested.
   class SharedPDSDelayedRetriever : public DelayedProductRetriever {
-    void getAsync(DataProductRetriever&, int index, TaskHolder) final {}
+  public:
+    void setSource(SharedPDSSource* iSource, unsigned int iLane) { source_ = iSource; lane_ = iLane; }
+    void getAsync(DataProductRetriever&, int index, TaskHolder) final;
+  private:
+    SharedPDSSource* source_ = nullptr;
+    unsigned int lane_ = 0;
   };
   
   class SharedPDSSource : public SharedSourceBase {
   public:
-    SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName);
+    //if iUsePread is true, each lane reads its own event using positional reads
+    //iPrefetchDepth is the maximum number of event records read ahead of the requests from the lanes
+    SharedPDSSource(unsigned int iNLanes, unsigned long long iNEvents, std::string const& iFileName, unsigned long long iFirstEvent=0, bool iUsePread=false,
+                    unsigned int iPrefetchDepth=0);
     SharedPDSSource(SharedPDSSource&&) = delete;
     SharedPDSSource(SharedPDSSource const&) = delete;
-    ~SharedPDSSource() = default;
+    ~SharedPDSSource();
 
   size_t numberOfDataProducts() const final;
   std::vector<DataProductRetriever>& dataProducts(unsigned int iLane, long iEventIndex) final;
@@ -33,19 +49,102 @@ namespace cce::tf {
 
   void printSummary() const final;
   private:
+  friend class SharedPDSDelayedRetriever;
   
   void readEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder) final;
+  void preadEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder);
+  void preadRecordAsync(unsigned int iLane, uint64_t iOffset, uint32_t iRecordSize, OptionalTaskHolder);
+  void prefetchEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder);
+
+  struct LaneInfo;
+  //works on LaneInfo::compressedBuffer_ of the lane
+  void decompressAndDeserialize(unsigned int iLane);
+  void getProductAsync(unsigned int iLane, DataProductRetriever&, int iIndex, TaskHolder);
+  void getProductFromBatch(unsigned int iLane, DataProductRetriever&, int iIndex);
+
+  //The read ahead records are read using positional reads outside of queue_. Until the read
+  // of a record finishes, a lane asking for it is kept in waitingTask_.
+  struct PrefetchedEvent {
+    unsigned long long fileEventIndex_;
+    EventIdentifier eventID_;
+    uint64_t offset_;
+    uint32_t recordSize_;
+    std::vector<uint32_t> buffer_;
+    std::chrono::microseconds readTime_{0};
+    bool ready_ = false;
+    unsigned int waitingLane_ = 0;
+    std::optional<OptionalTaskHolder> waitingTask_;
+  };
+  using PrefetchedIterator = std::list<PrefetchedEvent>::iterator;
+
+  //these must only be called from within queue_
+  //returns prefetched_.end() if the record is not being read ahead
+  PrefetchedIterator findPrefetched(long iEventIndex);
+  //gives the record to the lane and removes it from prefetched_
+  void deliverPrefetched(PrefetchedIterator, unsigned int iLane, OptionalTaskHolder);
+  //finds the next record in the file not yet asked for, returns false if there are none
+  bool nextRecordToRead(unsigned long long& oFileEventIndex, uint64_t& oOffset, uint32_t& oRecordSize, EventIdentifier&);
+  //starts reading records until prefetchDepth_ are read or being read
+  void prefetch(tbb::task_group&);
+  //replaces presentBatch_, returns false at the end of the file
+  bool readNextColumnarBatch();
+  //sets the batch and event identifier of the lane, returns false if there is no such event
+  bool setupColumnarEvent(LaneInfo&, long iEventIndex);
 
   std::chrono::microseconds readTime() const;
   std::chrono::microseconds decompressTime() const;
   std::chrono::microseconds deserializeTime() const;
 
   pds::Compression compression_;
+  //null if the file does not use a dictionary
+  pds::DecompressionDictionary dictionary_;
+  //only set if the file has data product references
+  std::unique_ptr<pds::ProductReferenceResolver> referenceResolver_;
+  //each data product in an event record was compressed separately
+  bool perProductCompression_ = false;
   std::ifstream file_;
   SerialTaskQueue queue_;
+  //empty if the file does not have an index
+  std::vector<pds::EventIndexEntry> eventIndex_;
+  unsigned long long firstEvent_;
+  //index of the event in the file the stream is presently positioned at
+  unsigned long long nextFileEventIndex_;
+  //only used for positional reads, which the read ahead also uses
+  bool usePread_;
+  int fileDescriptor_ = -1;
+  uint64_t nextOffset_ = 0;
+
+  //a list so the reads in flight can refer to their entry while others are removed
+  std::list<PrefetchedEvent> prefetched_;
+  std::vector<std::vector<uint32_t>> freeBuffers_;
+  //only used with an index, set once the record was read ahead or asked for by a lane
+  std::vector<bool> recordRequested_;
+  unsigned int prefetchDepth_;
+  bool reachedEndOfFile_ = false;
+  unsigned long long prefetchHits_ = 0;
+  unsigned long long prefetchMisses_ = 0;
+
+  //Shared by all lanes processing events from the batch. Each column is decompressed
+  // once, by the first lane requesting that data product.
+  struct ColumnarBatch {
+    std::vector<uint32_t> record_;
+    std::vector<EventIdentifier> eventIDs_;
+    std::vector<pds::CompressedProduct> columns_;
+    std::unique_ptr<std::once_flag[]> uncompressOnce_;
+    std::vector<std::vector<uint32_t>> uncompressedColumns_;
+  };
+  bool columnarBatches_ = false;
+  std::shared_ptr<ColumnarBatch> presentBatch_;
+  //only used without an index
+  size_t nextInBatch_ = 0;
+  //only used with an index, which has an entry for each event pointing to its batch record
+  //the position of each event within its batch
+  std::vector<uint32_t> positionsInBatch_;
+  //keyed by file offset, lets lanes asking for events of a batch still used by another lane share it
+  std::map<uint64_t, std::weak_ptr<ColumnarBatch>> batchesInUse_;
 
   struct LaneInfo {
-    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy);
+    LaneInfo(std::vector<pds::ProductInfo> const&);
 
     LaneInfo(LaneInfo&&) = default;
     LaneInfo(LaneInfo const&) = delete;
@@ -54,15 +153,27 @@ namespace cce::tf {
     LaneInfo& operator=(LaneInfo const&) = delete;
 
     EventIdentifier eventID_;
+    //holds the compressed record being processed by the lane
+    std::vector<uint32_t> compressedBuffer_;
     std::vector<DataProductRetriever> dataProducts_;
     std::vector<void*> dataBuffers_;
-    DeserializeStrategy deserializers_; //NOTE: could be shared between lanes?
     SharedPDSDelayedRetriever delayedRetriever_;
+    //only filled if each data product was compressed separately
+    std::vector<pds::CompressedProduct> compressedProducts_;
+    //only used if the file holds columnar batches
+    std::shared_ptr<ColumnarBatch> batch_;
+    uint32_t indexInBatch_ = 0;
+    //each entry is only changed by the task working on that data product
+    std::vector<std::chrono::microseconds> productDecompressTimes_;
+    std::vector<std::chrono::microseconds> productDeserializeTimes_;
+    std::chrono::microseconds readTime_;
     std::chrono::microseconds decompressTime_;
     std::chrono::microseconds deserializeTime_;
     ~LaneInfo();
   };
 
+  //the deserializers can be used concurrently so all lanes share them
+  DeserializeStrategy deserializers_;
   std::vector<LaneInfo> laneInfos_;
   std::chrono::microseconds readTime_;
   };
@@ -1,7 +1,5 @@
 #include "SharedRootBatchEventsSource.h"
 #include "SourceFactory.h"
-#include "Deserializer.h"
-#include "UnrolledDeserializer.h"
 
 #include "TClass.h"
 
@@ -77,9 +75,15 @@ SharedRootBatchEventsSource::SharedRootBatchEventsSource(unsigned int iNLanes, u
     compressionBranch->GetEntry(0);
     //std::cout <<"compressionAlgorithm "<<compression<<std::endl;
   }
+  ULong64_t layoutFingerprint = 0;
+  if(auto fingerprintBranch = meta->GetBranch("layoutFingerprint")) {
+    fingerprintBranch->SetAddress(&layoutFingerprint);
+    fingerprintBranch->GetEntry(0);
+  }
 
   assert(objectSerializationUsed == static_cast<int>(pds::Serialization::kRoot) or 
-         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled));
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled) or
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kRaw));
   pds::Serialization serialization{objectSerializationUsed};
 
   if (compression == "None") {
@@ -101,32 +105,23 @@ SharedRootBatchEventsSource::SharedRootBatchEventsSource(unsigned int iNLanes, u
       productInfo.emplace_back(name, index++, type);
     }
   }
+  pds::checkLayoutFingerprint(serialization, productInfo, layoutFingerprint);
 
+  deserializers_ = pds::makeDeserializeStrategy(serialization, productInfo, iNLanes);
   laneInfos_.reserve(iNLanes);
   for(unsigned int i = 0; i< iNLanes; ++i) {
-    DeserializeStrategy strategy;
-    switch(serialization) {
-    case pds::Serialization::kRoot: { 
-      strategy = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
-    }
-    case pds::Serialization::kRootUnrolled: {
-      strategy = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
-    }
-    }
-    laneInfos_.emplace_back(productInfo, std::move(strategy));
+    laneInfos_.emplace_back(productInfo);
   }
 
 
 }
 
-SharedRootBatchEventsSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy deserialize):
-  deserializers_{std::move(deserialize)},
+SharedRootBatchEventsSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo):
   decompressTime_{std::chrono::microseconds::zero()},
   deserializeTime_{std::chrono::microseconds::zero()}
 {
   dataProducts_.reserve(productInfo.size());
   dataBuffers_.resize(productInfo.size(), nullptr);
-  deserializers_.reserve(productInfo.size());
   size_t index =0;
   for(auto const& pi : productInfo) {
     
@@ -138,7 +133,6 @@ SharedRootBatchEventsSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> co
                                pi.name(),
                                cls,
 			       &delayedRetriever_);
-    deserializers_.emplace_back(cls);
     ++index;
   }
 }
@@ -226,7 +220,7 @@ void SharedRootBatchEventsSource::readEventAsync(unsigned int iLane, long iEvent
             //uBuffer.pop_back();
             pds::deserializeDataProducts(uBuffer.data(), uBuffer.data()+uBuffer.size(), 
                                          offsets.begin(), offsets.end(),
-                                         laneInfo.dataProducts_, laneInfo.deserializers_);
+                                         laneInfo.dataProducts_, deserializers_, iLane);
             laneInfo.deserializeTime_ += 
               std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
           });
@@ -1,7 +1,5 @@
 #include "SharedRootEventSource.h"
 #include "SourceFactory.h"
-#include "Deserializer.h"
-#include "UnrolledDeserializer.h"
 
 #include "TClass.h"
 
@@ -73,9 +71,15 @@ SharedRootEventSource::SharedRootEventSource(unsigned int iNLanes, unsigned long
     compressionBranch->GetEntry(0);
     //std::cout <<"compressionAlgorithm "<<compression<<std::endl;
   }
+  ULong64_t layoutFingerprint = 0;
+  if(auto fingerprintBranch = meta->GetBranch("layoutFingerprint")) {
+    fingerprintBranch->SetAddress(&layoutFingerprint);
+    fingerprintBranch->GetEntry(0);
+  }
 
   assert(objectSerializationUsed == static_cast<int>(pds::Serialization::kRoot) or 
-         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled));
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kRootUnrolled) or
+         objectSerializationUsed == static_cast<int>(pds::Serialization::kRaw));
   pds::Serialization serialization{objectSerializationUsed};
 
   if (compression == "None") {
@@ -97,32 +101,23 @@ SharedRootEventSource::SharedRootEventSource(unsigned int iNLanes, unsigned long
       productInfo.emplace_back(name, index++, type);
     }
   }
+  pds::checkLayoutFingerprint(serialization, productInfo, layoutFingerprint);
 
+  deserializers_ = pds::makeDeserializeStrategy(serialization, productInfo, iNLanes);
   laneInfos_.reserve(iNLanes);
   for(unsigned int i = 0; i< iNLanes; ++i) {
-    DeserializeStrategy strategy;
-    switch(serialization) {
-    case pds::Serialization::kRoot: { 
-      strategy = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
-    }
-    case pds::Serialization::kRootUnrolled: {
-      strategy = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
-    }
-    }
-    laneInfos_.emplace_back(productInfo, std::move(strategy));
+    laneInfos_.emplace_back(productInfo);
   }
 
 
 }
 
-SharedRootEventSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo, DeserializeStrategy deserialize):
-  deserializers_{std::move(deserialize)},
+SharedRootEventSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& productInfo):
   decompressTime_{std::chrono::microseconds::zero()},
   deserializeTime_{std::chrono::microseconds::zero()}
 {
   dataProducts_.reserve(productInfo.size());
   dataBuffers_.resize(productInfo.size(), nullptr);
-  deserializers_.reserve(productInfo.size());
   size_t index =0;
   for(auto const& pi : productInfo) {
     
@@ -134,7 +129,6 @@ SharedRootEventSource::LaneInfo::LaneInfo(std::vector<pds::ProductInfo> const& p
                                pi.name(),
                                cls,
 			       &delayedRetriever_);
-    deserializers_.emplace_back(cls);
     ++index;
   }
 }
@@ -194,7 +188,7 @@ void SharedRootEventSource::readEventAsync(unsigned int iLane, long iEventIndex,
             //uBuffer.pop_back();
             pds::deserializeDataProducts(uBuffer.data(), uBuffer.data()+uBuffer.size(), 
                                          offsetsAndBuffer.first.begin(), offsetsAndBuffer.first.end(),
-                                         laneInfo.dataProducts_, laneInfo.deserializers_);
+                                         laneInfo.dataProducts_, deserializers_, iLane);
             laneInfo.deserializeTime_ += 
               std::chrono::duration_cast<decltype(laneInfo.deserializeTime_)>(std::chrono::high_resolution_clock::now() - start);
           });
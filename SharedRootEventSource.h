@@ -52,7 +52,7 @@ namespace cce::tf {
   SerialTaskQueue queue_;
 
   struct LaneInfo {
-    LaneInfo(std::vector<pds::ProductInfo> const&, DeserializeStrategy);
+    LaneInfo(std::vector<pds::ProductInfo> const&);
 
     LaneInfo(LaneInfo&&) = default;
     LaneInfo(LaneInfo const&) = delete;
@@ -63,13 +63,14 @@ namespace cce::tf {
     EventIdentifier eventID_;
     std::vector<DataProductRetriever> dataProducts_;
     std::vector<void*> dataBuffers_;
-    DeserializeStrategy deserializers_; //NOTE: could be shared between lanes?
     SharedRootEventDelayedRetriever delayedRetriever_;
     std::chrono::microseconds decompressTime_;
     std::chrono::microseconds deserializeTime_;
     ~LaneInfo();
   };
 
+  //the deserializers can be used concurrently so all lanes share them
+  DeserializeStrategy deserializers_;
   std::vector<LaneInfo> laneInfos_;
   std::chrono::microseconds readTime_;
   };
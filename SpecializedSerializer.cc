@@ -0,0 +1,54 @@
+#include "SpecializedSerializer.h"
+
+#include <unordered_map>
+#include <typeindex>
+#include <mutex>
+
+using namespace cce::tf::specialized;
+
+namespace {
+  struct Registry {
+    std::mutex mutex_;
+    std::unordered_map<std::type_index, Entry> entries_;
+  };
+
+  Registry& registry() {
+    static Registry s_registry;
+    return s_registry;
+  }
+
+  Registration<std::vector<short>> s_vShort;
+  Registration<std::vector<unsigned short>> s_vUShort;
+  Registration<std::vector<int>> s_vInt;
+  Registration<std::vector<unsigned int>> s_vUInt;
+  Registration<std::vector<long long>> s_vLong64;
+  Registration<std::vector<unsigned long long>> s_vULong64;
+  Registration<std::vector<float>> s_vFloat;
+  Registration<std::vector<double>> s_vDouble;
+}
+
+std::atomic<unsigned int>& cce::tf::specialized::nInUse() {
+  static std::atomic<unsigned int> s_nInUse{0};
+  return s_nInUse;
+}
+
+void cce::tf::specialized::registerEntry(std::type_info const& iType, Entry iEntry) {
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.mutex_);
+  r.entries_.insert_or_assign(std::type_index(iType), iEntry);
+}
+
+Entry const* cce::tf::specialized::find(TClass const& iClass) {
+  auto typeInfo = iClass.GetTypeInfo();
+  if(not typeInfo) {
+    return nullptr;
+  }
+  auto& r = registry();
+  std::lock_guard<std::mutex> guard(r.mutex_);
+  auto found = r.entries_.find(std::type_index(*typeInfo));
+  if(found == r.entries_.end()) {
+    return nullptr;
+  }
+  //entries are never removed so the address stays valid
+  return &found->second;
+}
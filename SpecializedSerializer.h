@@ -0,0 +1,204 @@
+#if !defined(SpecializedSerializer_h)
+#define SpecializedSerializer_h
+
+#include <vector>
+#include <string>
+#include <tuple>
+#include <atomic>
+#include <type_traits>
+#include <typeinfo>
+#include "TBuffer.h"
+#include "TClass.h"
+#include "TDataType.h"
+#include "common_unrolling.h"
+
+/*---------------------------------------
+Serializers for types whose layout is known at compile time. They write the same
+bytes as the UnrolledSerializer but without going through the ROOT streamer actions.
+
+A class takes part by describing its data members, in the order they are declared,
+and registering itself in a .cc file, see specialized_layouts.cc
+
+  template<> struct cce::tf::specialized::Layout<MyClass> {
+    static constexpr auto members = std::make_tuple(&MyClass::m_a, &MyClass::m_b);
+  };
+  static cce::tf::specialized::Registration<MyClass> s_myClass;
+
+The members can be builtin types, enums, std::string, std::vectors of numeric builtin
+types or classes which have a Layout themselves. As done by the UnrolledSerializer,
+the members of nested classes are written in place and the std::vectors are written
+after all the other members. A class which ROOT can not unroll sets
+  static constexpr bool unrolled = false;
+in its Layout, it is then written as one object with its class version header.
+std::vectors of the numeric builtin types are registered by default.
+
+Before a specialized serializer is used its output for a sample object is compared
+to the output of the UnrolledSerializer, if they differ the UnrolledSerializer is used instead.
+  ---------------------------------------*/
+namespace cce::tf::specialized {
+  template<typename T>
+  struct Layout;
+
+  namespace detail {
+    template<typename T, typename = void>
+    struct HasLayout : std::false_type {};
+    template<typename T>
+    struct HasLayout<T, std::void_t<decltype(Layout<T>::members)>> : std::true_type {};
+
+    template<typename T, typename = void>
+    struct IsUnrolled : std::true_type {};
+    template<typename T>
+    struct IsUnrolled<T, std::void_t<decltype(Layout<T>::unrolled)>> : std::bool_constant<Layout<T>::unrolled> {};
+
+    template<typename T>
+    struct IsBuiltinVector : std::false_type {};
+    template<typename T>
+    struct IsBuiltinVector<std::vector<T>> : std::bool_constant<std::is_arithmetic_v<T> and not std::is_same_v<T, bool>> {};
+
+    template<typename T, typename F>
+    void forEachMember(T const& iObject, F&& iFunc) {
+      static_assert(HasLayout<T>::value, "the class needs a cce::tf::specialized::Layout");
+      std::apply([&iObject, &iFunc](auto... iMembers) { (iFunc(iObject.*iMembers), ...); }, Layout<T>::members);
+    }
+
+    template<typename T>
+    TClass* classFor() {
+      static TClass* const s_class = TClass::GetClass(typeid(T));
+      return s_class;
+    }
+
+    template<typename T>
+    void writeElements(TBuffer& iBuffer, std::vector<T> const& iObject) {
+      static EDataType const s_type = TDataType::GetType(typeid(T));
+      Int_t size = iObject.size();
+      iBuffer << size;
+      if(size > 0) {
+        unrolling::writeBuiltinArray(iBuffer, s_type, iObject.data(), size);
+      }
+    }
+
+    //builtins and strings are written the same way whether or not their class was unrolled
+    template<typename T>
+    void writeValue(TBuffer& iBuffer, T const& iObject) {
+      if constexpr(std::is_enum_v<T>) {
+        //ROOT streams enums as Int_t
+        iBuffer << static_cast<Int_t>(iObject);
+      } else if constexpr(std::is_arithmetic_v<T>) {
+        iBuffer << iObject;
+      } else {
+        static_assert(std::is_same_v<T, std::string>);
+        iBuffer.WriteStdString(&iObject);
+      }
+    }
+
+    template<typename T>
+    constexpr bool kIsValue = std::is_arithmetic_v<T> or std::is_enum_v<T> or std::is_same_v<T, std::string>;
+
+    //how ROOT streams an object of a class it did not unroll
+    template<typename T>
+    void writeWithVersion(TBuffer& iBuffer, T const& iObject) {
+      auto byteCountPosition = iBuffer.WriteVersion(classFor<T>(), kTRUE);
+      if constexpr(IsBuiltinVector<T>::value) {
+        writeElements(iBuffer, iObject);
+      } else {
+        forEachMember(iObject, [&iBuffer](auto const& iMember) {
+            using M = std::decay_t<decltype(iMember)>;
+            if constexpr(kIsValue<M>) {
+              writeValue(iBuffer, iMember);
+            } else {
+              writeWithVersion(iBuffer, iMember);
+            }
+          });
+      }
+      iBuffer.SetByteCount(byteCountPosition, kTRUE);
+    }
+
+    //the part the UnrolledSerializer writes before any of the collections
+    template<typename T>
+    void writeObjects(TBuffer& iBuffer, T const& iObject) {
+      if constexpr(kIsValue<T>) {
+        writeValue(iBuffer, iObject);
+      } else if constexpr(IsBuiltinVector<T>::value) {
+        //written by writeCollections
+      } else if constexpr(IsUnrolled<T>::value) {
+        forEachMember(iObject, [&iBuffer](auto const& iMember) { writeObjects(iBuffer, iMember); });
+      } else {
+        writeWithVersion(iBuffer, iObject);
+      }
+    }
+
+    template<typename T>
+    void writeCollections(TBuffer& iBuffer, T const& iObject) {
+      if constexpr(IsBuiltinVector<T>::value) {
+        writeElements(iBuffer, iObject);
+      } else if constexpr(HasLayout<T>::value and IsUnrolled<T>::value) {
+        forEachMember(iObject, [&iBuffer](auto const& iMember) { writeCollections(iBuffer, iMember); });
+      }
+    }
+  }
+
+  //matches the UnrolledSerializer for a top level object
+  template<typename T>
+  void write(TBuffer& iBuffer, TClass const* iClass, T const& iObject) {
+    using namespace detail;
+    if constexpr(IsBuiltinVector<T>::value) {
+      //ROOT does not unroll collections so they keep their version header
+      auto byteCountPosition = iBuffer.WriteVersion(iClass, kTRUE);
+      writeElements(iBuffer, iObject);
+      iBuffer.SetByteCount(byteCountPosition, kTRUE);
+    } else if constexpr(IsUnrolled<T>::value) {
+      writeObjects(iBuffer, iObject);
+      writeCollections(iBuffer, iObject);
+    } else {
+      //the members of the top level object are written without its own version header
+      forEachMember(iObject, [&iBuffer](auto const& iMember) {
+          using M = std::decay_t<decltype(iMember)>;
+          if constexpr(kIsValue<M>) {
+            writeValue(iBuffer, iMember);
+          } else {
+            writeWithVersion(iBuffer, iMember);
+          }
+        });
+    }
+  }
+
+  //the object used for the self check
+  template<typename T>
+  struct Sample {
+    static T* make() { return new T{}; }
+  };
+  template<typename T>
+  struct Sample<std::vector<T>> {
+    //non-empty so the check covers the element data
+    static std::vector<T>* make() { return new std::vector<T>{T(1), T(2), T(3)}; }
+  };
+
+  struct Entry {
+    void (*write_)(TBuffer&, TClass const*, void const*);
+    void* (*newSample_)();
+    void (*deleteSample_)(void*);
+  };
+
+  void registerEntry(std::type_info const&, Entry);
+  //returns nullptr if the class has no specialized serializer
+  Entry const* find(TClass const&);
+
+  //the number of serializers, summed over all lanes, which passed their self check
+  std::atomic<unsigned int>& nInUse();
+
+  template<typename T>
+  Entry makeEntry() {
+    return Entry{
+      [](TBuffer& iBuffer, TClass const* iClass, void const* iObject) { write(iBuffer, iClass, *static_cast<T const*>(iObject)); },
+      []() -> void* { return Sample<T>::make(); },
+      [](void* iObject) { delete static_cast<T*>(iObject); } };
+  }
+
+  //T is either a std::vector of a numeric builtin type or a class with a Layout
+  template<typename T>
+  struct Registration {
+    static_assert(detail::IsBuiltinVector<T>::value or detail::HasLayout<T>::value);
+    Registration() { registerEntry(typeid(T), makeEntry<T>()); }
+  };
+}
+#endif
@@ -0,0 +1,81 @@
+#if !defined(SpecializedSerializerWrapper_h)
+#define SpecializedSerializerWrapper_h
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "TClass.h"
+#include "TBufferFile.h"
+
+#include "tbb/task_group.h"
+#include "SpecializedSerializer.h"
+#include "UnrolledSerializerWrapper.h"
+#include "TaskHolder.h"
+#include "BlobView.h"
+
+namespace cce::tf {
+//Uses the specialized serializer registered for the class if it writes the same bytes
+// as the UnrolledSerializer, otherwise falls back to the UnrolledSerializer.
+class SpecializedSerializerWrapper {
+public:
+ SpecializedSerializerWrapper(std::string_view iName,  TClass* tClass):
+  unrolled_{iName, tClass}, class_(tClass), entry_{specialized::find(*tClass)}, bufferFile_{TBuffer::kWrite},
+  sizer_{BufferSizeStatistics::forProduct(iName)}, accumulatedTime_{std::chrono::microseconds::zero()} {
+    if(entry_) {
+      if(selfCheck()) {
+        ++specialized::nInUse();
+      } else {
+        entry_ = nullptr;
+      }
+    }
+  }
+
+  SpecializedSerializerWrapper(SpecializedSerializerWrapper&& iOther):
+  unrolled_{std::move(iOther.unrolled_)}, class_(iOther.class_), entry_{iOther.entry_}, bufferFile_{TBuffer::kWrite},
+  sizer_{std::move(iOther.sizer_)}, accumulatedTime_{iOther.accumulatedTime_} {}
+
+  void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) {
+    if(not entry_) {
+      unrolled_.doWorkAsync(iGroup, iAddress, std::move(iCallback));
+      return;
+    }
+    iGroup.run([this, iAddress, callback=std::move(iCallback)] () {
+	{
+	  auto start = std::chrono::high_resolution_clock::now();
+	  bufferFile_.Reset();
+	  sizer_.presize(bufferFile_);
+	  entry_->write_(bufferFile_, class_, *iAddress);
+	  sizer_.update(bufferFile_);
+	  blob_ = BlobView(bufferFile_.Buffer(), bufferFile_.Length());
+	  accumulatedTime_ += std::chrono::duration_cast<decltype(accumulatedTime_)>(std::chrono::high_resolution_clock::now() - start);
+	}
+	const_cast<TaskHolder&>(callback).doneWaiting();
+      });
+  }
+  BlobView blob() const {return entry_ ? blob_ : unrolled_.blob();}
+
+  std::string_view  name() const {return unrolled_.name();}
+  char const* className() const { return class_->GetName(); }
+  std::chrono::microseconds accumulatedTime() const { return entry_ ? accumulatedTime_ : unrolled_.accumulatedTime();}
+  unsigned long long bufferReallocations() const { return entry_ ? sizer_.reallocations() : unrolled_.bufferReallocations(); }
+private:
+  bool selfCheck() {
+    void* sample = entry_->newSample_();
+    UnrolledSerializer unrolled(class_);
+    auto expected = unrolled.serialize(sample);
+    bufferFile_.Reset();
+    entry_->write_(bufferFile_, class_, sample);
+    entry_->deleteSample_(sample);
+    return std::equal(expected.begin(), expected.end(), bufferFile_.Buffer(), bufferFile_.Buffer()+bufferFile_.Length());
+  }
+
+  UnrolledSerializerWrapper unrolled_;
+  BlobView blob_;
+  TClass* class_;
+  specialized::Entry const* entry_;
+  TBufferFile bufferFile_;
+  BufferSizer sizer_;
+  std::chrono::microseconds accumulatedTime_;
+};
+}
+#endif
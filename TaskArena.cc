@@ -0,0 +1,76 @@
+#include "TaskArena.h"
+
+#include <new>
+#include <cassert>
+
+using namespace cce::tf;
+
+TaskArena::~TaskArena() {
+  if(current_) {
+    current_->live_.fetch_sub(1, std::memory_order_release);
+  }
+#if !defined(NDEBUG)
+  for(auto const& s: slabs_) {
+    assert(s->live_.load() == 0);
+  }
+#endif
+}
+
+void TaskArena::startEvent() {
+  if(current_ and current_->used_ != 0) {
+    nextSlab();
+  }
+}
+
+void* TaskArena::allocate(std::size_t iSize) {
+  auto const alignment = alignof(std::max_align_t);
+  std::size_t const size = sizeof(Header) + (iSize+alignment-1)/alignment*alignment;
+  if(size > kSlabSize) {
+    ++tooLarge_;
+    return nullptr;
+  }
+  if(not current_ or current_->used_ + size > kSlabSize) {
+    nextSlab();
+  }
+  auto header = new (current_->memory_+current_->used_) Header{current_};
+  current_->used_ += size;
+  current_->live_.fetch_add(1, std::memory_order_relaxed);
+  ++allocations_;
+  return header+1;
+}
+
+void* TaskArena::allocateOnHeap(std::size_t iSize) {
+  auto header = new (::operator new(sizeof(Header)+iSize)) Header{nullptr};
+  return header+1;
+}
+
+void TaskArena::deallocate(void* iPtr) {
+  auto header = static_cast<Header*>(iPtr)-1;
+  if(header->slab_) {
+    //the release pairs with the acquire in nextSlab before the memory is reused
+    header->slab_->live_.fetch_sub(1, std::memory_order_release);
+  } else {
+    ::operator delete(header);
+  }
+}
+
+void TaskArena::nextSlab() {
+  if(current_) {
+    current_->live_.fetch_sub(1, std::memory_order_release);
+  }
+  current_ = nullptr;
+  for(auto& s: slabs_) {
+    if(s->live_.load(std::memory_order_acquire) == 0) {
+      current_ = s.get();
+      current_->used_ = 0;
+      ++slabReuses_;
+      break;
+    }
+  }
+  if(not current_) {
+    slabs_.push_back(std::make_unique<Slab>());
+    current_ = slabs_.back().get();
+    ++slabAllocations_;
+  }
+  current_->live_.fetch_add(1, std::memory_order_relaxed);
+}
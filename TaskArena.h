@@ -0,0 +1,60 @@
+#if !defined(TaskArena_h)
+#define TaskArena_h
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace cce::tf {
+  //Memory for the small tasks a Lane makes while processing an event. The memory is handed
+  // out from slabs by bumping a pointer and a slab is reused once all the tasks made in it
+  // have been deleted. startEvent moves to another slab so the tasks of one event share slabs
+  // which are freed together. Only one thread at a time may allocate from an arena, the
+  // tasks can be deleted from any thread.
+  class TaskArena {
+  public:
+    TaskArena() = default;
+    ~TaskArena();
+    TaskArena(TaskArena const&) = delete;
+    TaskArena& operator=(TaskArena const&) = delete;
+
+    void startEvent();
+
+    //returns nullptr if iSize is too large for a slab
+    void* allocate(std::size_t iSize);
+    //for objects not made in an arena
+    static void* allocateOnHeap(std::size_t iSize);
+    //works for memory from both allocate and allocateOnHeap
+    static void deallocate(void* iPtr);
+
+    unsigned long long allocations() const { return allocations_; }
+    unsigned long long slabAllocations() const { return slabAllocations_; }
+    unsigned long long slabReuses() const { return slabReuses_; }
+    unsigned long long tooLarge() const { return tooLarge_; }
+
+  private:
+    static constexpr std::size_t kSlabSize = 4096;
+
+    struct Slab {
+      //number of tasks not yet deleted, plus 1 while it is the slab being allocated from
+      std::atomic<unsigned int> live_{0};
+      std::size_t used_ = 0;
+      alignas(std::max_align_t) std::byte memory_[kSlabSize];
+    };
+    //placed in front of each allocation
+    struct alignas(std::max_align_t) Header {
+      Slab* slab_;
+    };
+
+    void nextSlab();
+
+    std::vector<std::unique_ptr<Slab>> slabs_;
+    Slab* current_ = nullptr;
+    unsigned long long allocations_ = 0;
+    unsigned long long slabAllocations_ = 0;
+    unsigned long long slabReuses_ = 0;
+    unsigned long long tooLarge_ = 0;
+  };
+}
+#endif
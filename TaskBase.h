@@ -2,6 +2,8 @@
 #define TaskBase_h
 
 #include <atomic>
+#include <cstddef>
+#include "TaskArena.h"
 
 namespace cce::tf {
 class TaskBase {
@@ -11,6 +13,15 @@ public:
   }
   virtual void execute() = 0;
 
+  //tasks can be made either on the heap or in a TaskArena, they are deleted the same way
+  static void* operator new(std::size_t iSize) { return TaskArena::allocateOnHeap(iSize); }
+  static void* operator new(std::size_t iSize, TaskArena& iArena) {
+    auto p = iArena.allocate(iSize);
+    return p ? p : TaskArena::allocateOnHeap(iSize);
+  }
+  static void operator delete(void* iPtr) { TaskArena::deallocate(iPtr); }
+  static void operator delete(void* iPtr, TaskArena&) { TaskArena::deallocate(iPtr); }
+
   void increment_ref_count() { ++refCount_;}
   bool decrement_ref_count() { return 0 == --refCount_;}
 private:
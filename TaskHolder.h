@@ -2,8 +2,10 @@
 #define TaskHolder_h
 
 #include <memory>
+#include <atomic>
 #include "tbb/task_group.h"
 #include "TaskBase.h"
+#include "SerialTaskQueue.h"
 
 namespace cce::tf {
 class TaskHolder {
@@ -53,10 +55,25 @@ public:
   TaskHolder& operator=(TaskHolder&&) = delete;
 
   tbb::task_group* group() { return group_;}
+
+  //If set, the thread releasing the last reference runs the task itself instead of
+  // handing it to the task_group. Nested inline runs are limited so the stack stays bounded.
+  // Tasks released while a SerialTaskQueue task is running are always scheduled so they do
+  // not extend the time the queue is held.
+  static void setRunInline(bool iRunInline) { s_runInline = iRunInline; }
+  static bool runInline() { return s_runInline.load(std::memory_order_relaxed); }
+
   void doneWaiting() {
     auto t = task_;
     task_ = nullptr;
     if(t->decrement_ref_count()) {
+      if(runInline() and s_inlineDepth < kMaxInlineDepth and not SerialTaskQueue::isRunningTask()) {
+        ++s_inlineDepth;
+        t->execute();
+        delete t;
+        --s_inlineDepth;
+        return;
+      }
       //std::cout <<"Task "<<t<<std::endl;
       group_->run([t]() {
 	  t->execute();
@@ -66,6 +83,10 @@ public:
     }
   }
 private:
+  static constexpr unsigned int kMaxInlineDepth = 16;
+  static inline std::atomic<bool> s_runInline{false};
+  static inline thread_local unsigned int s_inlineDepth = 0;
+
   tbb::task_group* group_;
   TaskBase* task_;
 };
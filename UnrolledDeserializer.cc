@@ -8,5 +8,12 @@
 using namespace cce::tf;
 using namespace cce::tf::unrolling;
 
-UnrolledDeserializer::UnrolledDeserializer(TClass* iClass): offsetAndSequences_{buildReadActionSequence(*iClass)}{}
+UnrolledDeserializer::UnrolledDeserializer(TClass* iClass, unsigned int iNLanes, bool iRawBuiltins):
+  offsetAndSequences_{cachedReadActionSequence(*iClass)},
+  rawBuiltins_{iRawBuiltins}{
+  laneProxies_.reserve(iNLanes);
+  for(unsigned int i=0; i<iNLanes; ++i) {
+    laneProxies_.push_back(makeCollectionProxies(*offsetAndSequences_));
+  }
+}
 
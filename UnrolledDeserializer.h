@@ -8,26 +8,29 @@
 #include "common_unrolling.h"
 
 namespace cce::tf {
+//All lanes of a source can share one instance. Calls from different lanes may run concurrently.
 class UnrolledDeserializer {
 public:
-  UnrolledDeserializer(TClass*);
+  //iRawBuiltins must match the value used by the UnrolledSerializer
+  UnrolledDeserializer(TClass*, unsigned int iNLanes=1, bool iRawBuiltins=false);
 
 
-  int deserialize(std::vector<char> const& iBuffer, void* iWriteTo) const {
-    return deserialize(&iBuffer.front(), iBuffer.size(), iWriteTo);
+  int deserialize(unsigned int iLane, std::vector<char> const& iBuffer, void* iWriteTo) const {
+    return deserialize(iLane, &iBuffer.front(), iBuffer.size(), iWriteTo);
   }
-  int deserialize(char const * iBuffer, size_t iBufferSize, void* iWriteTo) const{
+  int deserialize(unsigned int iLane, char const * iBuffer, size_t iBufferSize, void* iWriteTo) const{
     TBufferFile bufferFile{TBuffer::kRead};
 
     bufferFile.SetBuffer( const_cast<char*>(iBuffer), iBufferSize, kFALSE);
 
-    deserialize(bufferFile, iWriteTo, offsetAndSequences_.m_objects, offsetAndSequences_.m_collections);
+    deserialize(bufferFile, iWriteTo, offsetAndSequences_->m_objects, offsetAndSequences_->m_collections, laneProxies_[iLane]);
     return bufferFile.Length();
   }
 
 private:
   void deserialize(TBufferFile& bufferFile, void* address, 
-                   unrolling::OffsetAndSequences const& offsetAndSequences, unrolling::SequencesForCollections const& seq4Collections) const {
+                   unrolling::OffsetAndSequences const& offsetAndSequences, unrolling::SequencesForCollections const& seq4Collections,
+                   unrolling::CollectionProxies const& proxies) const {
     for(auto& offNSeq: offsetAndSequences) {
       //seq->Print();
       bufferFile.ApplySequence(*(offNSeq.second), static_cast<char*>(address)+offNSeq.first);
@@ -36,18 +39,39 @@ private:
     for(auto& coll: seq4Collections) {
       auto collAddress = static_cast<char const*>(address) + coll.m_offset;
       
-      TVirtualCollectionProxy::TPushPop helper(coll.m_collProxy.get(), const_cast<char*>(collAddress));
+      auto& collProxy = *proxies[coll.m_proxyIndex];
+      TVirtualCollectionProxy::TPushPop helper(&collProxy, const_cast<char*>(collAddress));
       Int_t size;
       bufferFile >> size;      
-      coll.m_collProxy->Allocate(size, true);
+      collProxy.Allocate(size, true);
+      
+      if(coll.m_builtinType != kNoType_t) {
+        if(size > 0) {
+          if(rawBuiltins_) {
+            unrolling::readRawBuiltinArray(bufferFile, coll.m_builtinType, collProxy[0], size);
+          } else {
+            unrolling::readBuiltinArray(bufferFile, coll.m_builtinType, collProxy[0], size);
+          }
+        }
+        continue;
+      }
       
       for(Int_t item=0; item<size; ++item) {
-        auto elementAddress = (*coll.m_collProxy)[item];
-        deserialize(bufferFile, elementAddress, coll.m_offsetAndSequences, coll.m_collections);
+        auto elementAddress = collProxy[item];
+        deserialize(bufferFile, elementAddress, coll.m_offsetAndSequences, coll.m_collections, proxies);
       }
     }
   }
-  unrolling::ObjectAndCollectionsSequences offsetAndSequences_;
+  unrolling::SharedSequences offsetAndSequences_;
+  //the collection proxies hold iteration state so each lane needs its own set
+  std::vector<unrolling::CollectionProxies> laneProxies_;
+  bool rawBuiltins_;
+};
+
+//Used by DeserializeProxy for the Raw serialization
+class RawDeserializer : public UnrolledDeserializer {
+public:
+  RawDeserializer(TClass* iClass, unsigned int iNLanes=1): UnrolledDeserializer(iClass, iNLanes, true) {}
 };
 }
 #endif
@@ -5,10 +5,118 @@
 #include "TStreamerElement.h"
 
 #include <iostream>
+#include <algorithm>
+
+#include "FunctorTask.h"
+#include "tbb/task_arena.h"
 
 using namespace cce::tf;
 using namespace cce::tf::unrolling;
 
-UnrolledSerializer::UnrolledSerializer(TClass* iClass):
+UnrolledSerializer::UnrolledSerializer(TClass* iClass, bool iRawBuiltins, BufferSizer iSizer):
   bufferFile_{TBuffer::kWrite},
-  offsetAndSequences_{buildWriteActionSequence(*iClass)} {}
+  offsetAndSequences_{cachedWriteActionSequence(*iClass)},
+  proxies_{makeCollectionProxies(*offsetAndSequences_)},
+  rawBuiltins_{iRawBuiltins},
+  sizer_{std::move(iSizer)} {}
+
+std::atomic<unsigned int> UnrolledSerializer::s_parallelThreshold{0};
+
+UnrolledSerializer::Chunk& UnrolledSerializer::chunk(std::size_t iIndex) {
+  //the chunks are held by pointer as running tasks refer to them while more are added
+  while(chunks_.size() <= iIndex) {
+    chunks_.emplace_back(std::make_unique<Chunk>(*offsetAndSequences_));
+  }
+  return *chunks_[iIndex];
+}
+
+void UnrolledSerializer::serializeAsync(tbb::task_group& iGroup, void const* address, TaskHolder iCallback) {
+  auto start = std::chrono::high_resolution_clock::now();
+  bufferFile_.Reset();
+  sizer_.presize(bufferFile_);
+  pendingChunks_.clear();
+
+  auto const threshold = s_parallelThreshold.load();
+  auto const& sequences = *offsetAndSequences_;
+  //more chunks than threads only adds task overhead
+  Int_t const maxChunksPerCollection = 2*tbb::this_task_arena::max_concurrency();
+
+  //run once all chunks are done and this call has finished with bufferFile_
+  TaskHolder stitchTask(iGroup, make_functor_task([this, callback=std::move(iCallback)]() mutable {
+        stitchChunks();
+        callback.doneWaiting();
+      }));
+
+  for(auto& offAndSeq: sequences.m_objects) {
+    bufferFile_.ApplySequence(*(offAndSeq.second), const_cast<char*>(static_cast<char const*>(address)+offAndSeq.first));
+  }
+
+  std::size_t nChunks = 0;
+  for(auto& coll: sequences.m_collections) {
+    auto collAddress = static_cast<char const*>(address) + coll.m_offset;
+
+    auto& collProxy = *proxies_[coll.m_proxyIndex];
+    TVirtualCollectionProxy::TPushPop helper(&collProxy, const_cast<char*>(collAddress));
+    Int_t size =collProxy.Size();
+    bufferFile_ << size;
+
+    if(threshold == 0 or size <= static_cast<Int_t>(threshold)) {
+      serializeElements(bufferFile_, proxies_, coll, collProxy, 0, size);
+      continue;
+    }
+
+    //the elements are written back to back so chunks can be serialized separately and concatenated
+    Int_t const nCollChunks = std::max<Int_t>(2, std::min<Int_t>(size/threshold, maxChunksPerCollection));
+    for(Int_t i = 0; i < nCollChunks; ++i) {
+      Int_t begin = static_cast<long long>(size)*i/nCollChunks;
+      Int_t end = static_cast<long long>(size)*(i+1)/nCollChunks;
+      auto& c = chunk(nChunks++);
+      pendingChunks_.push_back({bufferFile_.Length(), &c});
+      iGroup.run([this, &c, &coll, collAddress, begin, end, holder=stitchTask]() {
+          auto start = std::chrono::high_resolution_clock::now();
+          c.buffer_.Reset();
+          auto& proxy = *c.proxies_[coll.m_proxyIndex];
+          TVirtualCollectionProxy::TPushPop helper(&proxy, const_cast<char*>(collAddress));
+          serializeElements(c.buffer_, c.proxies_, coll, proxy, begin, end);
+          c.time_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+          const_cast<TaskHolder&>(holder).doneWaiting();
+        });
+    }
+  }
+  //do not keep the memory of chunks only needed by an earlier, larger, object
+  chunks_.resize(nChunks);
+  sizer_.update(bufferFile_);
+  mainTime_ = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+  stitchTask.doneWaiting();
+}
+
+void UnrolledSerializer::stitchChunks() {
+  auto start = std::chrono::high_resolution_clock::now();
+  if(pendingChunks_.empty()) {
+    blob_ = BlobView(bufferFile_.Buffer(), bufferFile_.Length());
+    lastSerializeTime_ = mainTime_;
+    return;
+  }
+
+  std::size_t size = bufferFile_.Length();
+  for(auto const& p: pendingChunks_) {
+    size += p.chunk_->buffer_.Length();
+  }
+  stitched_.resize(size);
+
+  auto chunksTime = std::chrono::microseconds::zero();
+  char* out = stitched_.data();
+  Int_t copied = 0;
+  for(auto const& p: pendingChunks_) {
+    out = std::copy(bufferFile_.Buffer()+copied, bufferFile_.Buffer()+p.offset_, out);
+    copied = p.offset_;
+    auto const& chunkBuffer = p.chunk_->buffer_;
+    out = std::copy(chunkBuffer.Buffer(), chunkBuffer.Buffer()+chunkBuffer.Length(), out);
+    chunksTime += p.chunk_->time_;
+  }
+  std::copy(bufferFile_.Buffer()+copied, bufferFile_.Buffer()+bufferFile_.Length(), out);
+
+  blob_ = BlobView(stitched_.data(), size);
+  lastSerializeTime_ = mainTime_ + chunksTime +
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+}
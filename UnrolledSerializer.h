@@ -2,54 +2,130 @@
 #define UnrolledSerializer_h
 
 #include <vector>
+#include <memory>
+#include <chrono>
+#include <atomic>
 #include "TBufferFile.h"
 #include "TClass.h"
 #include "TStreamerInfoActions.h"
+#include "tbb/task_group.h"
 #include "common_unrolling.h"
+#include "BlobView.h"
+#include "TaskHolder.h"
+#include "BufferSizer.h"
 
 namespace cce::tf {
 class UnrolledSerializer {
 public:
-  UnrolledSerializer(TClass*);
+  //iRawBuiltins is used by the Raw serialization to store builtin arrays in the native byte order
+  //iSizer pre-sizes the buffer, by default only from the objects given to this serializer
+  UnrolledSerializer(TClass*, bool iRawBuiltins=false, BufferSizer iSizer = BufferSizer{});
 
   UnrolledSerializer(UnrolledSerializer&& iOther):
-  bufferFile_{TBuffer::kWrite}, offsetAndSequences_(std::move(iOther.offsetAndSequences_))  {}
-  
+  bufferFile_{TBuffer::kWrite}, offsetAndSequences_(std::move(iOther.offsetAndSequences_)), proxies_(std::move(iOther.proxies_)), rawBuiltins_(iOther.rawBuiltins_), sizer_(std::move(iOther.sizer_))  {}
+
   UnrolledSerializer(UnrolledSerializer const& ) = delete;
 
-  std::vector<char> serialize(void const* address) {
+  //The returned blob refers to the internal buffer and is only valid until the next call
+  BlobView serialize(void const* address) {
     bufferFile_.Reset();
+    sizer_.presize(bufferFile_);
 
-    serialize(address, offsetAndSequences_.m_objects, offsetAndSequences_.m_collections);
+    serialize(bufferFile_, proxies_, address, offsetAndSequences_->m_objects, offsetAndSequences_->m_collections);
+    sizer_.update(bufferFile_);
 
-    //The blob contains the serialized data product
-    std::vector<char> blob(bufferFile_.Buffer(), bufferFile_.Buffer()+bufferFile_.Length());
-    return blob;
+    return BlobView(bufferFile_.Buffer(), bufferFile_.Length());
   }
 
+  //Top level collections with more elements than the threshold are split into chunks by
+  // serializeAsync. The number of chunks is the number of elements divided by the threshold,
+  // but at least 2 and at most twice the number of threads. A value of 0 turns off the splitting.
+  static void setParallelThreshold(unsigned int iNElements) { s_parallelThreshold = iNElements; }
+  static unsigned int parallelThreshold() { return s_parallelThreshold; }
+
+  //Gives the same bytes as serialize but the chunks of large top level collections are
+  // serialized concurrently using iGroup and then stitched together. iCallback is
+  // released once blob() and lastSerializeTime() hold the result.
+  void serializeAsync(tbb::task_group& iGroup, void const* address, TaskHolder iCallback);
+  BlobView blob() const { return blob_; }
+  //summed over all the tasks used by the last serializeAsync call
+  std::chrono::microseconds lastSerializeTime() const { return lastSerializeTime_; }
+
+  //the chunk buffers of serializeAsync are not included
+  BufferSizer const& sizer() const { return sizer_; }
+
 private:
-  void serialize(void const* address, unrolling::OffsetAndSequences& offsetAndSequences, unrolling::SequencesForCollections& seq4Collections) {
+  //each chunk being serialized concurrently needs its own buffer and collection proxies
+  struct Chunk {
+    explicit Chunk(unrolling::ObjectAndCollectionsSequences const& iSequences):
+      buffer_{TBuffer::kWrite}, proxies_{unrolling::makeCollectionProxies(iSequences)} {}
+    TBufferFile buffer_;
+    unrolling::CollectionProxies proxies_;
+    std::chrono::microseconds time_{0};
+  };
+  struct PendingChunk {
+    //where in bufferFile_ the chunk's bytes belong
+    Int_t offset_;
+    Chunk const* chunk_;
+  };
+
+  void serialize(TBufferFile& oBuffer, unrolling::CollectionProxies const& iProxies, void const* address,
+                 unrolling::OffsetAndSequences const& offsetAndSequences, unrolling::SequencesForCollections const& seq4Collections) const {
     for(auto& offAndSeq: offsetAndSequences) {
       //seq->Print();
-      bufferFile_.ApplySequence(*(offAndSeq.second), const_cast<char*>(static_cast<char const*>(address)+offAndSeq.first));
+      oBuffer.ApplySequence(*(offAndSeq.second), const_cast<char*>(static_cast<char const*>(address)+offAndSeq.first));
     }
 
     for(auto& coll: seq4Collections) {
       auto collAddress = static_cast<char const*>(address) + coll.m_offset;
 
-      TVirtualCollectionProxy::TPushPop helper(coll.m_collProxy.get(), const_cast<char*>(collAddress));
-      Int_t size =coll.m_collProxy->Size();
-      bufferFile_ << size;
+      auto& collProxy = *iProxies[coll.m_proxyIndex];
+      TVirtualCollectionProxy::TPushPop helper(&collProxy, const_cast<char*>(collAddress));
+      Int_t size =collProxy.Size();
+      oBuffer << size;
 
-      for(Int_t item=0; item<size; ++item) {
-        auto elementAddress = (*coll.m_collProxy)[item];
-        serialize(elementAddress, coll.m_offsetAndSequences, coll.m_collections);
+      serializeElements(oBuffer, iProxies, coll, collProxy, 0, size);
+    }
+  }
+
+  //collProxy must already be pushed to the collection
+  void serializeElements(TBufferFile& oBuffer, unrolling::CollectionProxies const& iProxies, unrolling::CollectionActions const& coll,
+                         TVirtualCollectionProxy& collProxy, Int_t iBegin, Int_t iEnd) const {
+    if(coll.m_builtinType != kNoType_t) {
+      if(iEnd > iBegin) {
+        if(rawBuiltins_) {
+          unrolling::writeRawBuiltinArray(oBuffer, coll.m_builtinType, collProxy[iBegin], iEnd-iBegin);
+        } else {
+          unrolling::writeBuiltinArray(oBuffer, coll.m_builtinType, collProxy[iBegin], iEnd-iBegin);
+        }
       }
+      return;
+    }
+
+    for(Int_t item=iBegin; item<iEnd; ++item) {
+      auto elementAddress = collProxy[item];
+      serialize(oBuffer, iProxies, elementAddress, coll.m_offsetAndSequences, coll.m_collections);
     }
   }
 
+  Chunk& chunk(std::size_t iIndex);
+  void stitchChunks();
+
+  static std::atomic<unsigned int> s_parallelThreshold;
+
   TBufferFile bufferFile_;
-  unrolling::ObjectAndCollectionsSequences offsetAndSequences_;
+  unrolling::SharedSequences offsetAndSequences_;
+  unrolling::CollectionProxies proxies_;
+  bool rawBuiltins_;
+  BufferSizer sizer_;
+
+  //only used by serializeAsync
+  BlobView blob_;
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  std::vector<PendingChunk> pendingChunks_;
+  std::vector<char> stitched_;
+  std::chrono::microseconds mainTime_{0};
+  std::chrono::microseconds lastSerializeTime_{0};
 };
 }
 #endif
@@ -8,15 +8,28 @@
 #include "tbb/task_group.h"
 #include "UnrolledSerializer.h"
 #include "TaskHolder.h"
+#include "FunctorTask.h"
+#include "BlobView.h"
 
 namespace cce::tf {
 class UnrolledSerializerWrapper {
 public:
- UnrolledSerializerWrapper(std::string_view iName,  TClass* tClass):
-  name_{iName}, class_(tClass), serializer_{tClass},
+ UnrolledSerializerWrapper(std::string_view iName,  TClass* tClass, bool iRawBuiltins=false):
+  name_{iName}, class_(tClass), serializer_{tClass, iRawBuiltins, BufferSizer{BufferSizeStatistics::forProduct(iName)}},
   accumulatedTime_{std::chrono::microseconds::zero()} {}
 
   void doWorkAsync(tbb::task_group& iGroup, void** iAddress, TaskHolder iCallback) {
+    if(UnrolledSerializer::parallelThreshold() != 0) {
+      iGroup.run([this, &iGroup, iAddress, callback=std::move(iCallback)] () {
+          serializer_.serializeAsync(iGroup, *iAddress,
+                                     TaskHolder(iGroup, make_functor_task([this, callback=std::move(const_cast<TaskHolder&>(callback))]() mutable {
+                                           blob_ = serializer_.blob();
+                                           accumulatedTime_ += serializer_.lastSerializeTime();
+                                           callback.doneWaiting();
+                                         })));
+        });
+      return;
+    }
     iGroup.run([this, iAddress, callback=std::move(iCallback)] () {
 	{
           //gDebug=3;
@@ -28,17 +41,25 @@ public:
 	const_cast<TaskHolder&>(callback).doneWaiting();
       });
   }
-  std::vector<char> const& blob() const {return blob_;}
+  BlobView blob() const {return blob_;}
 
   std::string_view  name() const {return name_;}
   char const* className() const { return class_->GetName(); }
   std::chrono::microseconds accumulatedTime() const { return accumulatedTime_;}
+  unsigned long long bufferReallocations() const { return serializer_.sizer().reallocations(); }
 private:
-  std::vector<char> blob_;
+  BlobView blob_;
   std::string_view name_;
   TClass const* class_;
   UnrolledSerializer serializer_;
   std::chrono::microseconds accumulatedTime_;
 };
+
+//Used by SerializeProxy for the Raw serialization
+class RawSerializerWrapper : public UnrolledSerializerWrapper {
+public:
+ RawSerializerWrapper(std::string_view iName,  TClass* tClass):
+  UnrolledSerializerWrapper(iName, tClass, true) {}
+};
 }
 #endif
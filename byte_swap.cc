@@ -0,0 +1,120 @@
+#include "byte_swap.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define BYTE_SWAP_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+  using namespace cce::tf::byte_swap;
+
+  using Kernel = void(*)(void*, void const*, std::size_t);
+
+  //memcpy keeps the loads and stores valid for any alignment
+  template<typename T, T (*SWAP)(T)>
+  void scalarTail(char* oTo, char const* iFrom, std::size_t iN) {
+    for(std::size_t i=0; i<iN; ++i) {
+      T v;
+      std::memcpy(&v, iFrom+i*sizeof(T), sizeof(T));
+      v = SWAP(v);
+      std::memcpy(oTo+i*sizeof(T), &v, sizeof(T));
+    }
+  }
+  uint16_t swap16(uint16_t v) { return __builtin_bswap16(v); }
+  uint32_t swap32(uint32_t v) { return __builtin_bswap32(v); }
+  uint64_t swap64(uint64_t v) { return __builtin_bswap64(v); }
+
+  void scalar2(void* oTo, void const* iFrom, std::size_t iN) {
+    scalarTail<uint16_t, swap16>(static_cast<char*>(oTo), static_cast<char const*>(iFrom), iN);
+  }
+  void scalar4(void* oTo, void const* iFrom, std::size_t iN) {
+    scalarTail<uint32_t, swap32>(static_cast<char*>(oTo), static_cast<char const*>(iFrom), iN);
+  }
+  void scalar8(void* oTo, void const* iFrom, std::size_t iN) {
+    scalarTail<uint64_t, swap64>(static_cast<char*>(oTo), static_cast<char const*>(iFrom), iN);
+  }
+
+#if defined(BYTE_SWAP_X86)
+  //byte shuffle masks reversing each 2, 4 or 8 byte value within a 16 byte lane
+  template<std::size_t SIZE>
+  struct Mask;
+  template<> struct Mask<2> { static constexpr char v[16] = {1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14}; };
+  template<> struct Mask<4> { static constexpr char v[16] = {3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12}; };
+  template<> struct Mask<8> { static constexpr char v[16] = {7,6,5,4,3,2,1,0,15,14,13,12,11,10,9,8}; };
+
+  template<std::size_t SIZE, typename T, T (*SWAP)(T)>
+  __attribute__((target("ssse3")))
+  void ssse3(void* oTo, void const* iFrom, std::size_t iN) {
+    auto to = static_cast<char*>(oTo);
+    auto from = static_cast<char const*>(iFrom);
+    const __m128i mask = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Mask<SIZE>::v));
+    constexpr std::size_t kPerVector = 16/SIZE;
+    std::size_t i = 0;
+    for(; i+kPerVector <= iN; i += kPerVector) {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(from+i*SIZE));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(to+i*SIZE), _mm_shuffle_epi8(v, mask));
+    }
+    scalarTail<T, SWAP>(to+i*SIZE, from+i*SIZE, iN-i);
+  }
+
+  template<std::size_t SIZE, typename T, T (*SWAP)(T)>
+  __attribute__((target("avx2")))
+  void avx2(void* oTo, void const* iFrom, std::size_t iN) {
+    auto to = static_cast<char*>(oTo);
+    auto from = static_cast<char const*>(iFrom);
+    //_mm256_shuffle_epi8 works within each 16 byte half so the same mask is used for both
+    const __m128i half = _mm_loadu_si128(reinterpret_cast<__m128i const*>(Mask<SIZE>::v));
+    const __m256i mask = _mm256_broadcastsi128_si256(half);
+    constexpr std::size_t kPerVector = 32/SIZE;
+    std::size_t i = 0;
+    for(; i+kPerVector <= iN; i += kPerVector) {
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(from+i*SIZE));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(to+i*SIZE), _mm256_shuffle_epi8(v, mask));
+    }
+    scalarTail<T, SWAP>(to+i*SIZE, from+i*SIZE, iN-i);
+  }
+#endif
+
+  //picked once based on what the CPU running the job supports
+  struct Kernels {
+    Kernels() {
+#if defined(BYTE_SWAP_X86)
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx2")) {
+        swap2_ = avx2<2, uint16_t, swap16>;
+        swap4_ = avx2<4, uint32_t, swap32>;
+        swap8_ = avx2<8, uint64_t, swap64>;
+        return;
+      }
+      if(__builtin_cpu_supports("ssse3")) {
+        swap2_ = ssse3<2, uint16_t, swap16>;
+        swap4_ = ssse3<4, uint32_t, swap32>;
+        swap8_ = ssse3<8, uint64_t, swap64>;
+        return;
+      }
+#endif
+    }
+    Kernel swap2_ = scalar2;
+    Kernel swap4_ = scalar4;
+    Kernel swap8_ = scalar8;
+  };
+
+  Kernels const& kernels() {
+    static const Kernels s_kernels;
+    return s_kernels;
+  }
+}
+
+namespace cce::tf::byte_swap {
+  void copySwap2(void* oTo, void const* iFrom, std::size_t iN) {
+    kernels().swap2_(oTo, iFrom, iN);
+  }
+  void copySwap4(void* oTo, void const* iFrom, std::size_t iN) {
+    kernels().swap4_(oTo, iFrom, iN);
+  }
+  void copySwap8(void* oTo, void const* iFrom, std::size_t iN) {
+    kernels().swap8_(oTo, iFrom, iN);
+  }
+}
@@ -0,0 +1,14 @@
+#if !defined(byte_swap_h)
+#define byte_swap_h
+
+#include <cstddef>
+
+namespace cce::tf::byte_swap {
+  //Copy iN values of 2, 4 or 8 bytes from iFrom to oTo reversing the byte order of
+  // each value. Converts between the host order and ROOT's big-endian on-disk
+  // order in either direction. The two ranges must not overlap and need no alignment.
+  void copySwap2(void* oTo, void const* iFrom, std::size_t iN);
+  void copySwap4(void* oTo, void const* iFrom, std::size_t iN);
+  void copySwap8(void* oTo, void const* iFrom, std::size_t iN);
+}
+#endif
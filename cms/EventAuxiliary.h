@@ -9,6 +9,11 @@
 
 // Auxiliary event data that is persistent
 
+namespace cce::tf::specialized {
+  template <typename T>
+  struct Layout;
+}
+
 namespace edm {
   class EventAux;
   class EventAuxiliary {
@@ -77,6 +82,10 @@ namespace edm {
     int orbitNumber() const { return orbitNumber_; }
     int storeNumber() const { return storeNumber_; }
 
+    //lets the specialized serializer refer to the data members
+    template <typename T>
+    friend struct cce::tf::specialized::Layout;
+
   private:
     // Process history ID of the full process history (not the reduced process history)
     ProcessHistoryID processHistoryID_;
@@ -26,6 +26,11 @@
 #include "RunLumiEventNumber.h"
 
 // forward declarations
+namespace cce::tf::specialized {
+  template <typename T>
+  struct Layout;
+}
+
 namespace edm {
 
   class EventID {
@@ -100,6 +105,10 @@ namespace edm {
 
     void setLuminosityBlockNumber(LuminosityBlockNumber_t const& lb) { luminosityBlock_ = lb; }
 
+    //lets the specialized serializer refer to the data members
+    template <typename T>
+    friend struct cce::tf::specialized::Layout;
+
   private:
     //EventID(EventID const&); // stop default
 
@@ -0,0 +1,6 @@
+#include "Hash.h"
+
+namespace edm::detail {
+  static std::string const invalidHash;
+  std::string const& InvalidHash() { return invalidHash;}
+}
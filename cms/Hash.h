@@ -19,6 +19,11 @@ namespace cms {
   class Digest;
 }
 
+namespace cce::tf::specialized {
+  template <typename T>
+  struct Layout;
+}
+
 namespace edm {
 
   namespace detail {
@@ -83,6 +88,10 @@ namespace edm {
     // CMS_CLASS_VERSION(11) // This macro is not defined here, so expand it.
     static short Class_Version() { return 11; }
 
+    //lets the specialized serializer refer to the data members
+    template <typename T>
+    friend struct cce::tf::specialized::Layout;
+
   private:
     /// Hexified version of data *must* contain a multiple of 2
     /// bytes. If it does not, throw an exception.
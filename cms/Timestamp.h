@@ -24,6 +24,11 @@
 // user include files
 
 // forward declarations
+namespace cce::tf::specialized {
+  template <typename T>
+  struct Layout;
+}
+
 namespace edm {
   typedef unsigned long long TimeValue_t;
 
@@ -85,6 +90,10 @@ namespace edm {
 
     // ---------- member functions ---------------------------
 
+    //lets the specialized serializer refer to the data members
+    template <typename T>
+    friend struct cce::tf::specialized::Layout;
+
   private:
     //Timestamp(Timestamp const&); // allow default
 
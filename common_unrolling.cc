@@ -5,10 +5,19 @@
 #include "TClonesArray.h"
 #include "TStreamerElement.h"
 #include "TStreamerInfo.h"
-#include "SequenceFinderForBuiltins.h"
+#include "TBuffer.h"
+#include "byte_swap.h"
+
+#include "tbb/parallel_for_each.h"
 
 #include <set>
 #include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <stdexcept>
 
 using namespace cce::tf;
 namespace {
@@ -17,6 +26,7 @@ namespace {
   void checkIfCanHandle(TClass* iClass);
   bool elementNeedsOwnSequence(TStreamerElement* element, TClass* cl);
   bool canUnroll(TClass* iClass, TStreamerInfo* sinfo);
+  bool isBulkBuiltin(EDataType iType);
 
   unrolling::Sequence setActionSequence(TClass *originalClass, TStreamerInfo *localInfo, TVirtualCollectionProxy* collectionProxy, TStreamerInfoActions::TActionSequence::SequenceGetter_t create, bool isSplitNode, int iID, size_t iOffset );
 
@@ -197,6 +207,111 @@ namespace {
     return true;
   }
 
+  //these are the types TBuffer can stream with WriteFastArray/ReadFastArray
+  // using the same bytes as streaming each element on its own
+  bool isBulkBuiltin(EDataType iType) {
+    switch(iType) {
+    case kFloat_t:
+    case kDouble_t:
+    case kInt_t:
+    case kUInt_t:
+    case kLong_t:
+    case kULong_t:
+    case kLong64_t:
+    case kULong64_t:
+    case kShort_t:
+    case kUShort_t:
+    case kChar_t:
+    case kUChar_t:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+#if defined(R__BYTESWAP)
+  //ROOT always streams Long_t and ULong_t as 8 bytes
+  template<typename T>
+  constexpr bool kCanCopySwap = sizeof(T) > 1 and 
+    (sizeof(T) == 8 or not (std::is_same_v<T, Long_t> or std::is_same_v<T, ULong_t>));
+
+  template<typename T>
+  void copySwap(void* oTo, void const* iFrom, std::size_t iN) {
+    if constexpr(sizeof(T) == 2) {
+      byte_swap::copySwap2(oTo, iFrom, iN);
+    } else if constexpr(sizeof(T) == 4) {
+      byte_swap::copySwap4(oTo, iFrom, iN);
+    } else {
+      static_assert(sizeof(T) == 8);
+      byte_swap::copySwap8(oTo, iFrom, iN);
+    }
+  }
+#endif
+
+  std::size_t builtinSize(EDataType iType) {
+    switch(iType) {
+    case kFloat_t: { return sizeof(Float_t); }
+    case kDouble_t: { return sizeof(Double_t); }
+    case kInt_t: { return sizeof(Int_t); }
+    case kUInt_t: { return sizeof(UInt_t); }
+    case kLong_t: { return sizeof(Long_t); }
+    case kULong_t: { return sizeof(ULong_t); }
+    case kLong64_t: { return sizeof(Long64_t); }
+    case kULong64_t: { return sizeof(ULong64_t); }
+    case kShort_t: { return sizeof(Short_t); }
+    case kUShort_t: { return sizeof(UShort_t); }
+    case kChar_t: { return sizeof(Char_t); }
+    case kUChar_t: { return sizeof(UChar_t); }
+    default:
+      //only the types from isBulkBuiltin are used
+      abort();
+    }
+  }
+
+  //FNV-1a
+  void addToFingerprint(uint64_t& ioHash, void const* iData, std::size_t iSize) {
+    auto data = static_cast<unsigned char const*>(iData);
+    for(std::size_t i=0; i<iSize; ++i) {
+      ioHash ^= data[i];
+      ioHash *= 0x100000001b3ULL;
+    }
+  }
+
+  template<typename T>
+  void writeArray(TBuffer& iBuffer, void const* iFirstElement, Int_t iSize) {
+#if defined(R__BYTESWAP)
+    if constexpr(kCanCopySwap<T>) {
+      //swap straight into the buffer rather than one value at a time
+      Int_t const start = iBuffer.Length();
+      Int_t const nBytes = iSize*sizeof(T);
+      if(start+nBytes > iBuffer.BufferSize()) {
+        iBuffer.AutoExpand(start+nBytes);
+      }
+      copySwap<T>(iBuffer.Buffer()+start, iFirstElement, iSize);
+      iBuffer.SetBufferOffset(start+nBytes);
+      return;
+    }
+#endif
+    iBuffer.WriteFastArray(static_cast<T const*>(iFirstElement), iSize);
+  }
+
+  template<typename T>
+  void readArray(TBuffer& iBuffer, void* iFirstElement, Int_t iSize) {
+#if defined(R__BYTESWAP)
+    if constexpr(kCanCopySwap<T>) {
+      Int_t const start = iBuffer.Length();
+      Int_t const nBytes = iSize*sizeof(T);
+      //if the buffer is too short let ReadFastArray report the problem
+      if(start+nBytes <= iBuffer.BufferSize()) {
+        copySwap<T>(iFirstElement, iBuffer.Buffer()+start, iSize);
+        iBuffer.SetBufferOffset(start+nBytes);
+        return;
+      }
+    }
+#endif
+    iBuffer.ReadFastArray(static_cast<T*>(iFirstElement), iSize);
+  }
+
 //  NOTE: fNewIDs are filled in via InitInfo which is called by GetInfoImp (which returns the TStreamerInfo). It only does
 //   work if dealing with a container rather than an object.
   unrolling::Sequence setActionSequence(TClass *originalClass, TStreamerInfo *localInfo, TVirtualCollectionProxy* collectionProxy, TStreamerInfoActions::TActionSequence::SequenceGetter_t create, bool isSplitNode, int iID, size_t iOffset )
@@ -278,68 +393,10 @@ namespace {
         //std::cout <<"!CanSplit "<<ptr->GetName()<<std::endl; 
         auto collProxy = ptr->GetCollectionProxy(); 
         if(collProxy && collProxy->GetCollectionType() ==  ROOT::kSTLvector) {
-          if(not collProxy->GetValueClass()) {
-            TClass* proxyClass = nullptr;
-            switch(collProxy->GetType()) {
-            case kFloat_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<float>));
-                break;
-              }
-            case kDouble_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<double>));
-                break;
-              }
-            case kInt_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<int>));
-                break;
-              }
-            case kUInt_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned int>));
-                break;
-              }
-            case kLong_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<long>));
-                break;
-              }
-            case kULong_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned long>));
-                break;
-              }
-            case kShort_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<short>));
-                break;
-              }
-            case kUShort_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned short>));
-                break;
-              }
-            case kChar_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<char>));
-                break;
-              }
-            case kUChar_t:
-              {
-                proxyClass = TClass::GetClass(typeid(cce::tf::SequenceFinderForBuiltins<unsigned char>));
-                break;
-              }
-            }
-            if(proxyClass) {
-              //std::cout <<"using prox class"<<std::endl;
-              TStreamerInfo* sinfo = buildStreamerInfo(proxyClass,nullptr);
-              oCollections.emplace_back(collProxy->Generate(), baseOffset+element->GetOffset());
-              //base offset is 0 since it is relative to the item in the container
-              oCollections.back().m_offsetAndSequences.emplace_back(0, setActionSequence(nullptr, sinfo, nullptr, create, false, -1, 0));
-              return;
-            }
+          if(not collProxy->GetValueClass() and isBulkBuiltin(collProxy->GetType())) {
+            //the elements are contiguous so no per element action sequence is needed
+            oCollections.emplace_back(collProxy->Generate(), baseOffset+element->GetOffset(), collProxy->GetType());
+            return;
           }
         }
         
@@ -387,15 +444,174 @@ namespace {
  }
 }
 
+namespace {
+  //depth first numbering, returns the next unused index
+  unsigned int assignProxyIndices(unrolling::SequencesForCollections& iCollections, unsigned int iNextIndex) {
+    for(auto& coll: iCollections) {
+      coll.m_proxyIndex = iNextIndex++;
+      iNextIndex = assignProxyIndices(coll.m_collections, iNextIndex);
+    }
+    return iNextIndex;
+  }
+
+  void generateProxies(unrolling::SequencesForCollections const& iCollections, unrolling::CollectionProxies& oProxies) {
+    for(auto const& coll: iCollections) {
+      oProxies[coll.m_proxyIndex].reset(coll.m_collProxy->Generate());
+      generateProxies(coll.m_collections, oProxies);
+    }
+  }
+
+  class SequenceCache {
+  public:
+    using Builder = unrolling::ObjectAndCollectionsSequences (*)(TClass&);
+
+    unrolling::SharedSequences get(TClass& iClass, Builder iBuilder) {
+      std::shared_ptr<Entry> entry;
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto& found = entries_[&iClass];
+        if(not found) {
+          found = std::make_shared<Entry>();
+        }
+        entry = found;
+      }
+      //different classes can be built concurrently
+      std::call_once(entry->once_, [&]() {
+          entry->sequences_ = std::make_shared<unrolling::ObjectAndCollectionsSequences const>(iBuilder(iClass));
+        });
+      return entry->sequences_;
+    }
+  private:
+    struct Entry {
+      std::once_flag once_;
+      unrolling::SharedSequences sequences_;
+    };
+    std::mutex mutex_;
+    std::unordered_map<TClass const*, std::shared_ptr<Entry>> entries_;
+  };
+
+  void prebuild(std::vector<TClass*> const& iClasses, unrolling::SharedSequences (*iGet)(TClass&)) {
+    std::vector<TClass*> classes(iClasses);
+    std::sort(classes.begin(), classes.end());
+    classes.erase(std::unique(classes.begin(), classes.end()), classes.end());
+    tbb::parallel_for_each(classes.begin(), classes.end(), [iGet](TClass* iClass) { iGet(*iClass); });
+  }
+}
+
 namespace cce::tf::unrolling {
   unrolling::ObjectAndCollectionsSequences buildReadActionSequence(TClass& iClass) {
-    return buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::ReadMemberWiseActionsGetter);
+    auto sequences = buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::ReadMemberWiseActionsGetter);
+    sequences.m_nCollections = assignProxyIndices(sequences.m_collections, 0);
+    return sequences;
   }
 
   unrolling::ObjectAndCollectionsSequences buildWriteActionSequence(TClass& iClass) {
-    return buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::WriteMemberWiseActionsGetter);
+    auto sequences = buildActionSequence(iClass, TStreamerInfoActions::TActionSequence::WriteMemberWiseActionsGetter);
+    sequences.m_nCollections = assignProxyIndices(sequences.m_collections, 0);
+    return sequences;
+  }
+
+  SharedSequences cachedReadActionSequence(TClass& iClass) {
+    static SequenceCache s_cache;
+    return s_cache.get(iClass, buildReadActionSequence);
+  }
+
+  SharedSequences cachedWriteActionSequence(TClass& iClass) {
+    static SequenceCache s_cache;
+    return s_cache.get(iClass, buildWriteActionSequence);
+  }
+
+  void prebuildReadActionSequences(std::vector<TClass*> const& iClasses) {
+    prebuild(iClasses, cachedReadActionSequence);
   }
 
+  void prebuildWriteActionSequences(std::vector<TClass*> const& iClasses) {
+    prebuild(iClasses, cachedWriteActionSequence);
+  }
+
+  CollectionProxies makeCollectionProxies(ObjectAndCollectionsSequences const& iSequences) {
+    CollectionProxies proxies(iSequences.m_nCollections);
+    generateProxies(iSequences.m_collections, proxies);
+    return proxies;
+  }
+
+  void writeBuiltinArray(TBuffer& iBuffer, EDataType iType, void const* iFirstElement, Int_t iSize) {
+    switch(iType) {
+    case kFloat_t: { writeArray<Float_t>(iBuffer, iFirstElement, iSize); break; }
+    case kDouble_t: { writeArray<Double_t>(iBuffer, iFirstElement, iSize); break; }
+    case kInt_t: { writeArray<Int_t>(iBuffer, iFirstElement, iSize); break; }
+    case kUInt_t: { writeArray<UInt_t>(iBuffer, iFirstElement, iSize); break; }
+    case kLong_t: { writeArray<Long_t>(iBuffer, iFirstElement, iSize); break; }
+    case kULong_t: { writeArray<ULong_t>(iBuffer, iFirstElement, iSize); break; }
+    case kLong64_t: { writeArray<Long64_t>(iBuffer, iFirstElement, iSize); break; }
+    case kULong64_t: { writeArray<ULong64_t>(iBuffer, iFirstElement, iSize); break; }
+    case kShort_t: { writeArray<Short_t>(iBuffer, iFirstElement, iSize); break; }
+    case kUShort_t: { writeArray<UShort_t>(iBuffer, iFirstElement, iSize); break; }
+    case kChar_t: { writeArray<Char_t>(iBuffer, iFirstElement, iSize); break; }
+    case kUChar_t: { writeArray<UChar_t>(iBuffer, iFirstElement, iSize); break; }
+    default:
+      //buildWriteActionSequence only selects the types above
+      abort();
+    }
+  }
+
+  void readBuiltinArray(TBuffer& iBuffer, EDataType iType, void* iFirstElement, Int_t iSize) {
+    switch(iType) {
+    case kFloat_t: { readArray<Float_t>(iBuffer, iFirstElement, iSize); break; }
+    case kDouble_t: { readArray<Double_t>(iBuffer, iFirstElement, iSize); break; }
+    case kInt_t: { readArray<Int_t>(iBuffer, iFirstElement, iSize); break; }
+    case kUInt_t: { readArray<UInt_t>(iBuffer, iFirstElement, iSize); break; }
+    case kLong_t: { readArray<Long_t>(iBuffer, iFirstElement, iSize); break; }
+    case kULong_t: { readArray<ULong_t>(iBuffer, iFirstElement, iSize); break; }
+    case kLong64_t: { readArray<Long64_t>(iBuffer, iFirstElement, iSize); break; }
+    case kULong64_t: { readArray<ULong64_t>(iBuffer, iFirstElement, iSize); break; }
+    case kShort_t: { readArray<Short_t>(iBuffer, iFirstElement, iSize); break; }
+    case kUShort_t: { readArray<UShort_t>(iBuffer, iFirstElement, iSize); break; }
+    case kChar_t: { readArray<Char_t>(iBuffer, iFirstElement, iSize); break; }
+    case kUChar_t: { readArray<UChar_t>(iBuffer, iFirstElement, iSize); break; }
+    default:
+      //buildReadActionSequence only selects the types above
+      abort();
+    }
+  }
+
+  void writeRawBuiltinArray(TBuffer& iBuffer, EDataType iType, void const* iFirstElement, Int_t iSize) {
+    Int_t const start = iBuffer.Length();
+    Int_t const nBytes = iSize*builtinSize(iType);
+    if(start+nBytes > iBuffer.BufferSize()) {
+      iBuffer.AutoExpand(start+nBytes);
+    }
+    std::memcpy(iBuffer.Buffer()+start, iFirstElement, nBytes);
+    iBuffer.SetBufferOffset(start+nBytes);
+  }
+
+  void readRawBuiltinArray(TBuffer& iBuffer, EDataType iType, void* iFirstElement, Int_t iSize) {
+    Int_t const start = iBuffer.Length();
+    Int_t const nBytes = iSize*builtinSize(iType);
+    if(start+nBytes > iBuffer.BufferSize()) {
+      throw std::runtime_error("Raw serialization: buffer too short to read array");
+    }
+    std::memcpy(iFirstElement, iBuffer.Buffer()+start, nBytes);
+    iBuffer.SetBufferOffset(start+nBytes);
+  }
+
+  uint64_t rawLayoutFingerprint(std::vector<std::string> const& iClassNames) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const uint16_t byteOrder = 0x0102;
+    addToFingerprint(hash, &byteOrder, sizeof(byteOrder));
+    const uint32_t sizes[] = {sizeof(void*), sizeof(Long_t), sizeof(Int_t), sizeof(Double_t)};
+    addToFingerprint(hash, sizes, sizeof(sizes));
+    for(auto const& name: iClassNames) {
+      addToFingerprint(hash, name.data(), name.size()+1);
+      TClass* cls = TClass::GetClass(name.c_str());
+      if(cls) {
+        //the checksum covers the names and types of the data members
+        const uint32_t layout[] = {cls->GetCheckSum(), static_cast<uint32_t>(cls->Size())};
+        addToFingerprint(hash, layout, sizeof(layout));
+      }
+    }
+    return hash;
+  }
 }
 
 
@@ -3,19 +3,29 @@
 
 #include "TClass.h"
 #include "TStreamerInfoActions.h"
+#include "TDataType.h"
 #include <memory>
 #include <vector>
+#include <string>
+#include <cstdint>
 
 namespace cce::tf::unrolling {
   using Sequence = std::unique_ptr<TStreamerInfoActions::TActionSequence>;  
   using OffsetAndSequences = std::vector<std::pair<int, Sequence>>;
 
   struct CollectionActions {
-  CollectionActions( TVirtualCollectionProxy* proxy, int offset): 
-    m_collProxy(proxy), m_offset(offset) {}
+  CollectionActions( TVirtualCollectionProxy* proxy, int offset, EDataType builtinType = kNoType_t):
+    m_collProxy(proxy), m_offset(offset), m_builtinType(builtinType) {}
 
+    //a proxy can not be used concurrently so this one is only used to Generate the
+    // proxies each user gets from makeCollectionProxies
     std::unique_ptr<TVirtualCollectionProxy> m_collProxy;
     int m_offset;
+    //index of the proxy to use from makeCollectionProxies
+    unsigned int m_proxyIndex = 0;
+    //if not kNoType_t the collection is a std::vector of that builtin type and
+    // its elements are streamed as one block instead of using m_offsetAndSequences
+    EDataType m_builtinType;
     OffsetAndSequences m_offsetAndSequences;
 
     std::vector<CollectionActions> m_collections;
@@ -26,11 +36,37 @@ namespace cce::tf::unrolling {
   struct ObjectAndCollectionsSequences {
     OffsetAndSequences m_objects;
     SequencesForCollections m_collections;
+    //number of collections including the nested ones
+    unsigned int m_nCollections = 0;
   };
 
   ObjectAndCollectionsSequences buildReadActionSequence(TClass& iClass);
   ObjectAndCollectionsSequences buildWriteActionSequence(TClass& iClass);
 
+  //The sequences are built once per class for the whole process and then shared.
+  // Applying a sequence does not modify it so they can be used concurrently.
+  using SharedSequences = std::shared_ptr<ObjectAndCollectionsSequences const>;
+  SharedSequences cachedReadActionSequence(TClass& iClass);
+  SharedSequences cachedWriteActionSequence(TClass& iClass);
 
+  //builds concurrently the sequences of the classes not yet in the cache
+  void prebuildReadActionSequences(std::vector<TClass*> const& iClasses);
+  void prebuildWriteActionSequences(std::vector<TClass*> const& iClasses);
+
+  //each UnrolledSerializer/UnrolledDeserializer needs its own collection proxies
+  using CollectionProxies = std::vector<std::unique_ptr<TVirtualCollectionProxy>>;
+  CollectionProxies makeCollectionProxies(ObjectAndCollectionsSequences const&);
+
+  //iFirstElement is the address of the first of the iSize contiguous elements
+  void writeBuiltinArray(TBuffer& iBuffer, EDataType iType, void const* iFirstElement, Int_t iSize);
+  void readBuiltinArray(TBuffer& iBuffer, EDataType iType, void* iFirstElement, Int_t iSize);
+
+  //same as above but the bytes are copied as they are in memory, used by the Raw serialization
+  void writeRawBuiltinArray(TBuffer& iBuffer, EDataType iType, void const* iFirstElement, Int_t iSize);
+  void readRawBuiltinArray(TBuffer& iBuffer, EDataType iType, void* iFirstElement, Int_t iSize);
+
+  //Identifies what the Raw serialization of the classes depends on: the byte order and
+  // type sizes of the machine and the class layouts. iClassNames must be in data product order.
+  uint64_t rawLayoutFingerprint(std::vector<std::string> const& iClassNames);
 }
 #endif
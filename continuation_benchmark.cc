@@ -0,0 +1,172 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "CLI11.hpp"
+
+#include "EmptySource.h"
+#include "DataProductRetriever.h"
+#include "DelayedProductRetriever.h"
+#include "OptionalTaskHolder.h"
+#include "TaskHolder.h"
+#include "FunctorTask.h"
+#include "SerialTaskQueue.h"
+
+#include "tbb/task_group.h"
+#include "tbb/global_control.h"
+#include "tbb/task_arena.h"
+
+namespace {
+  using namespace cce::tf;
+
+  //same products as the TestProductsSource but without needing ROOT for their TClass
+  class IntsRetriever : public DelayedProductRetriever {
+  public:
+    void getAsync(DataProductRetriever& iRetriever, int index, TaskHolder iCallback) final {
+      int ei = static_cast<int>(eventIndex_);
+      ints_[index] = {ei, ei+1, ei+2};
+      iRetriever.setSize(sizeof(int)*3);
+      iCallback.doneWaiting();
+    }
+    void setEventIndex(long iIndex) { eventIndex_ = iIndex; }
+    void** address(int index) { return reinterpret_cast<void**>(&intsPtr_[index]); }
+
+  private:
+    std::vector<int> ints_[2];
+    std::vector<int>* intsPtr_[2] = {&ints_[0], &ints_[1]};
+    long eventIndex_ = -1;
+  };
+
+  class ProductsSource : public SharedSourceBase {
+  public:
+    ProductsSource(unsigned int iNLanes, unsigned long long iNEvents):
+      SharedSourceBase(iNEvents),
+      delayedPerLane_(iNLanes) {
+      retrieverPerLane_.reserve(iNLanes);
+      for(unsigned int lane=0; lane<iNLanes; ++lane) {
+        std::vector<DataProductRetriever> r;
+        r.reserve(2);
+        r.emplace_back(0, delayedPerLane_[lane].address(0), "ints", nullptr, &delayedPerLane_[lane]);
+        r.emplace_back(1, delayedPerLane_[lane].address(1), "moreInts", nullptr, &delayedPerLane_[lane]);
+        retrieverPerLane_.emplace_back(std::move(r));
+      }
+    }
+
+    size_t numberOfDataProducts() const final { return 2; }
+    std::vector<DataProductRetriever>& dataProducts(unsigned int iLane, long iEventIndex) final { return retrieverPerLane_[iLane]; }
+    EventIdentifier eventIdentifier(unsigned int iLane, long iEventIndex) final {
+      return {1, 1, static_cast<unsigned long long>(iEventIndex+1)};
+    }
+    void printSummary() const final {}
+
+  private:
+    void readEventAsync(unsigned int iLane, long iEventIndex,  OptionalTaskHolder iTask) final {
+      delayedPerLane_[iLane].setEventIndex(iEventIndex);
+      iTask.runNow();
+    }
+
+    std::vector<IntsRetriever> delayedPerLane_;
+    std::vector<std::vector<DataProductRetriever>> retrieverPerLane_;
+  };
+
+  //follows the task structure of a Lane: get the products, write the event from a SerialTaskQueue
+  // the way the outputers do, then start the next event from the callback
+  struct BenchmarkLane {
+    SharedSourceBase* source_;
+    SerialTaskQueue* queue_;
+    tbb::task_group* group_;
+    std::atomic<long>* nextEventIndex_;
+    //only modified from within the queue
+    unsigned long long* nWritten_;
+    unsigned int index_;
+
+    void doNextEvent() {
+      long eventIndex = (*nextEventIndex_)++;
+      if(not source_->mayBeAbleToGoToEvent(eventIndex)) {
+        return;
+      }
+      OptionalTaskHolder processEventTask(*group_, make_functor_task([this, eventIndex]() {
+            TaskHolder nextEvent(*group_, make_functor_task([this]() { doNextEvent(); }));
+            TaskHolder output(*group_, make_functor_task([this, callback=std::move(nextEvent)]() mutable {
+                  queue_->push(*group_, [this, callback=std::move(callback)]() mutable {
+                      ++(*nWritten_);
+                      callback.doneWaiting();
+                    });
+                }));
+            for(auto& d: source_->dataProducts(index_, eventIndex)) {
+              d.getAsync(output);
+            }
+          }));
+      source_->gotoEventAsync(index_, eventIndex, std::move(processEventTask));
+    }
+  };
+
+  std::chrono::microseconds run(SharedSourceBase& iSource, unsigned int iNLanes, unsigned long long iNEvents) {
+    SerialTaskQueue queue;
+    tbb::task_group group;
+    std::atomic<long> nextEventIndex{0};
+    unsigned long long nWritten = 0;
+
+    std::vector<BenchmarkLane> lanes;
+    lanes.reserve(iNLanes);
+    for(unsigned int i=0; i<iNLanes; ++i) {
+      lanes.push_back({&iSource, &queue, &group, &nextEventIndex, &nWritten, i});
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for(auto& l: lanes) {
+      group.run([&l]() { l.doNextEvent(); });
+    }
+    group.wait();
+    auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+    if(nWritten != iNEvents) {
+      std::cout <<"ERROR: wrong number of events written "<<nWritten<<std::endl;
+      exit(1);
+    }
+    return time;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  CLI::App app{"compare scheduling continuations with running them inline"};
+
+  int parallelism = tbb::this_task_arena::max_concurrency();
+  app.add_option("-t,--num-threads", parallelism, "number of threads to use.\nDefault is all cores on the machine.");
+
+  unsigned int nLanes = 0;
+  app.add_option("-l,--num-lanes", nLanes, "number of concurrent events.\nDefault is number of threads.");
+
+  unsigned long long nEvents = 100000;
+  app.add_option("-n,--num-events", nEvents, "number of events to process.\nDefault is 100000.");
+
+  CLI11_PARSE(app, argc, argv);
+
+  if(nLanes == 0) {
+    nLanes = parallelism;
+  }
+
+  tbb::global_control c(tbb::global_control::max_allowed_parallelism, parallelism);
+  tbb::task_arena arena(parallelism);
+
+  std::cout <<"# threads "<<parallelism<<" # lanes "<<nLanes<<" # events "<<nEvents<<"\n";
+  for(bool products: {false, true}) {
+    for(bool runInline: {false, true}) {
+      TaskHolder::setRunInline(runInline);
+      std::unique_ptr<SharedSourceBase> source;
+      if(products) {
+        source = std::make_unique<ProductsSource>(nLanes, nEvents);
+      } else {
+        source = std::make_unique<EmptySource>(nEvents);
+      }
+      std::chrono::microseconds time;
+      arena.execute([&]() { time = run(*source, nLanes, nEvents); });
+      std::cout <<(products ? "products" : "empty   ")
+                <<(runInline ? " inline   " : " scheduled")
+                <<" time: "<<time.count()<<"us"
+                <<" events/s: "<<nEvents/(time.count()/1000000.)<<"\n";
+    }
+  }
+  TaskHolder::setRunInline(false);
+}
@@ -42,6 +42,8 @@ namespace cce::tf::pds {
       return pds::Serialization::kRoot;
     } else if(serializationName == "ROOTUnrolled" or serializationName=="Unrolled") {
       return pds::Serialization::kRootUnrolled;
+    } else if(serializationName == "Raw") {
+      return pds::Serialization::kRaw;
     }
     return {};
   }
@@ -3,10 +3,16 @@
 
 #include <optional>
 #include <string_view>
+#include <cstdint>
+
+#include "EventIdentifier.h"
 
 namespace cce::tf::pds {
   enum class Compression {kNone, kLZ4, kZSTD};
-  enum class Serialization {kRoot, kRootUnrolled};
+  //kRaw is the unrolled layout with the elements of std::vectors of builtin types stored in the
+  // native byte order. All other members, including the class version headers, are written as
+  // for kRootUnrolled. It can only be read where the layout fingerprint matches, see common_unrolling.h
+  enum class Serialization {kRoot, kRootUnrolled, kRaw};
 
   //returned value is guaranteed to have starting 4 
   // characters be unique for each compression factor
@@ -15,5 +21,44 @@ namespace cce::tf::pds {
 
   std::optional<Compression> toCompression(std::string_view);
   std::optional<Serialization> toSerialization(std::string_view);  
+
+  //bits of the file flags word which follows the file type identifier
+  constexpr uint32_t kFileHasDictionary = 0x1;
+  //each data product in an event record is compressed separately, see pds_reading.h
+  constexpr uint32_t kFileHasPerProductCompression = 0x2;
+  //event records are replaced by columnar batch records, see pds_reading.h
+  constexpr uint32_t kFileHasColumnarBatches = 0x4;
+  //the header is followed by the 64 bit layout fingerprint of a kRaw file (low word, high word)
+  constexpr uint32_t kFileHasLayoutFingerprint = 0x8;
+  //a data product identical to the last one stored for its product index is replaced by
+  // a reference to the event record storing it. Requires kFileHasPerProductCompression, see pds_reading.h
+  constexpr uint32_t kFileHasProductReferences = 0x10;
+  //set in the number of words stored for a data product when it is a reference
+  constexpr uint32_t kProductReferenceBit = 0x80000000;
+  //a reference holds the file offset (low word, high word) of the event record storing the data product
+  constexpr uint32_t kProductReferenceSizeInWords = 2;
+
+  constexpr size_t kEventHeaderSizeInWords = 5;
+  //first word of a record header
+  constexpr uint32_t kEventRecordType = 0;
+  constexpr uint32_t kColumnarBatchRecordType = 1;
+  //words used to store an EventIdentifier: run, lumi, event high word, event low word
+  constexpr size_t kEventIdentifierSizeInWords = 4;
+
+  //The event index record follows the last event record in a file.
+  // Layout in words: marker, # entries, then kEventIndexEntrySizeInWords per event.
+  // It is followed by the footer: index record offset (low word, high word) and the footer marker.
+  constexpr uint32_t kEventIndexRecordMarker = 0x58444E49; //"INDX"
+  constexpr uint32_t kEventIndexFooterMarker = 0x544F4F46; //"FOOT"
+  constexpr size_t kEventIndexEntrySizeInWords = 7;
+  constexpr size_t kEventIndexFooterSizeInWords = 3;
+
+  struct EventIndexEntry {
+    //file position of the start of the event record header
+    uint64_t offset;
+    //same as the size stored in the event record, i.e. excludes the header and crosscheck words
+    uint32_t recordSize;
+    EventIdentifier eventID;
+  };
 }
 #endif
@@ -4,11 +4,19 @@
 #include <algorithm>
 #include <iostream>
 
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <stdexcept>
+
 #include "lz4.h"
 #include "zstd.h"
 
 #include "TClass.h"
 #include "TBufferFile.h"
+#include "common_unrolling.h"
+#include "Deserializer.h"
+#include "UnrolledDeserializer.h"
 
 using namespace cce::tf::pds;
 
@@ -27,19 +35,34 @@ namespace {
   return Compression::kNone;
 }
 
+  //each thread reuses one decompression context rather than making a new one per call
+  struct DecompressionContext {
+    DecompressionContext(): zstd_(ZSTD_createDCtx()) {}
+    ~DecompressionContext() { ZSTD_freeDCtx(zstd_); }
+    DecompressionContext(DecompressionContext const&) = delete;
+    DecompressionContext& operator=(DecompressionContext const&) = delete;
+    ZSTD_DCtx* zstd_;
+  };
+
+  ZSTD_DCtx* decompressionContext() {
+    static thread_local DecompressionContext s_context;
+    return s_context.zstd_;
+  }
+
   struct Preamble {
     uint32_t bufferSize;
     Compression compression;
     Serialization serialization;
+    uint32_t flags;
   };
 Preamble readPreamble(std::istream& iFile) {
   std::array<uint32_t, 4> header;
   iFile.read(reinterpret_cast<char*>(header.data()),4*4);
   assert(iFile.rdstate() == std::ios_base::goodbit);
 
-  assert(3141592*256+1 == header[0] or 3141592*256+2 == header[0]);
-  Serialization serialization = (header[0] -3141592*256-1) == 0? Serialization::kRoot : Serialization::kRootUnrolled; 
-  return {header[3], whichCompression(reinterpret_cast<const char*>(&header[2])), serialization};
+  assert(3141592*256+1 <= header[0] and header[0] <= 3141592*256+3);
+  Serialization serialization = static_cast<Serialization>(header[0] -3141592*256-1);
+  return {header[3], whichCompression(reinterpret_cast<const char*>(&header[2])), serialization, header[1]};
 }
 
 using buffer_iterator = std::vector<std::uint32_t>::const_iterator;
@@ -112,6 +135,39 @@ size_t bytesToWords(size_t nBytes) {
   return info;
 }
 
+  //returns number of bytes read which is only less than iNBytes at the end of the file
+  size_t preadFully(int iFileDescriptor, char* oBuffer, size_t iNBytes, uint64_t iOffset) {
+    size_t nRead = 0;
+    while(nRead < iNBytes) {
+      auto n = pread(iFileDescriptor, oBuffer+nRead, iNBytes-nRead, iOffset+nRead);
+      if(n == 0) {
+        break;
+      }
+      if(n < 0) {
+        if(errno == EINTR) {
+          continue;
+        }
+        throw std::runtime_error("pread failed");
+      }
+      nRead += n;
+    }
+    return nRead;
+  }
+
+  std::vector<EventIndexEntry> eventIndexFromWords(uint32_t const* itBuffer, uint32_t nEntries) {
+    std::vector<EventIndexEntry> index;
+    index.reserve(nEntries);
+    for(uint32_t i=0; i<nEntries; ++i) {
+      uint64_t offset = itBuffer[1];
+      offset = (offset << 32) + itBuffer[0];
+      unsigned long long event = itBuffer[5];
+      event = (event << 32) + itBuffer[6];
+      index.push_back({offset, itBuffer[2], {itBuffer[3], itBuffer[4], event}});
+      itBuffer += kEventIndexEntrySizeInWords;
+    }
+    return index;
+  }
+
 }
 
 using namespace cce::tf;
@@ -137,10 +193,19 @@ std::vector<uint32_t> pds::readWords(std::istream& iFile, uint32_t bufferSize) {
 }
 
 std::vector<ProductInfo> pds::readFileHeader(std::istream& file, Compression& compression, Serialization& serialization) {
+  std::vector<char> dictionary;
+  uint32_t flags;
+  uint64_t fingerprint;
+  return readFileHeader(file, compression, serialization, dictionary, flags, fingerprint);
+}
+
+std::vector<ProductInfo> pds::readFileHeader(std::istream& file, Compression& compression, Serialization& serialization, std::vector<char>& oDictionary,
+                                             uint32_t& oFlags, uint64_t& oLayoutFingerprint) {
   auto preamble = readPreamble(file);
   auto bufferSize = preamble.bufferSize;
   compression = preamble.compression;
   serialization = preamble.serialization;
+  oFlags = preamble.flags;
 
   //1 word beyond the buffer is the crosscheck value
   std::vector<uint32_t> buffer = readWords(file, bufferSize+1);
@@ -156,9 +221,137 @@ std::vector<ProductInfo> pds::readFileHeader(std::istream& file, Compression& co
   assert(itBuffer+1 == itEnd);
   //std::cout <<*itBuffer <<" "<<bufferSize<<std::endl;
   assert(*itBuffer == bufferSize);
+
+  oDictionary.clear();
+  if(preamble.flags & kFileHasDictionary) {
+    //dictionary size in bytes, the dictionary padded to a word boundary, then the size again
+    uint32_t dictionarySize = readword(file);
+    auto words = readWords(file, bytesToWords(dictionarySize)+1);
+    assert(words.back() == dictionarySize);
+    auto begin = reinterpret_cast<char const*>(words.data());
+    oDictionary.assign(begin, begin+dictionarySize);
+  }
+  oLayoutFingerprint = 0;
+  if(preamble.flags & kFileHasLayoutFingerprint) {
+    auto words = readWords(file, 2);
+    oLayoutFingerprint = (uint64_t(words[1]) << 32) + words[0];
+  }
   return productInfo;
 }
 
+DecompressionDictionary pds::makeDecompressionDictionary(std::vector<char> const& iDictionary) {
+  if(iDictionary.empty()) {
+    return {};
+  }
+  return DecompressionDictionary(ZSTD_createDDict(iDictionary.data(), iDictionary.size()));
+}
+
+void pds::checkLayoutFingerprint(Serialization iSerialization, std::vector<ProductInfo> const& iProductInfo, uint64_t iLayoutFingerprint) {
+  if(iSerialization != Serialization::kRaw) {
+    return;
+  }
+  std::vector<std::string> classNames;
+  classNames.reserve(iProductInfo.size());
+  for(auto const& pi: iProductInfo) {
+    classNames.push_back(pi.className());
+  }
+  if(iLayoutFingerprint != unrolling::rawLayoutFingerprint(classNames)) {
+    throw std::runtime_error("file was written with Raw serialization using a different data layout");
+  }
+}
+
+DeserializeStrategy pds::makeDeserializeStrategy(Serialization iSerialization, std::vector<ProductInfo> const& iProductInfo, unsigned int iNLanes) {
+  std::vector<TClass*> classes;
+  classes.reserve(iProductInfo.size());
+  for(auto const& pi: iProductInfo) {
+    TClass* cls = TClass::GetClass(pi.className().c_str());
+    assert(cls);
+    classes.push_back(cls);
+  }
+
+  DeserializeStrategy strategy;
+  switch(iSerialization) {
+  case Serialization::kRoot: {
+    strategy = DeserializeStrategy::make<DeserializeProxy<Deserializer>>(); break;
+  }
+  case Serialization::kRootUnrolled: {
+    strategy = DeserializeStrategy::make<DeserializeProxy<UnrolledDeserializer>>(); break;
+  }
+  case Serialization::kRaw: {
+    strategy = DeserializeStrategy::make<DeserializeProxy<RawDeserializer>>(); break;
+  }
+  }
+  if(iSerialization != Serialization::kRoot) {
+    unrolling::prebuildReadActionSequences(classes);
+  }
+  strategy.reserve(classes.size());
+  for(auto cls: classes) {
+    strategy.emplace_back(cls, iNLanes);
+  }
+  return strategy;
+}
+
+namespace {
+  //the footer comes from the file so it must be checked before it is used to locate the index
+  bool eventIndexFitsInFile(uint64_t iIndexOffset, uint64_t iNEntries, uint64_t iFileSize) {
+    uint64_t const indexEnd = iFileSize - kEventIndexFooterSizeInWords*4;
+    if(iIndexOffset > indexEnd or indexEnd - iIndexOffset < 2*4) {
+      return false;
+    }
+    return iNEntries*kEventIndexEntrySizeInWords*4 <= indexEnd - iIndexOffset - 2*4;
+  }
+}
+
+std::vector<EventIndexEntry> pds::readEventIndex(std::istream& iFile) {
+  auto presentPosition = iFile.tellg();
+  std::vector<EventIndexEntry> index;
+
+  iFile.seekg(0, std::ios_base::end);
+  uint64_t fileSize = iFile.tellg();
+  if(iFile and fileSize >= kEventIndexFooterSizeInWords*4) {
+    std::array<uint32_t, kEventIndexFooterSizeInWords> footer;
+    iFile.seekg(fileSize - kEventIndexFooterSizeInWords*4);
+    iFile.read(reinterpret_cast<char*>(footer.data()), kEventIndexFooterSizeInWords*4);
+    if(iFile and footer[2] == kEventIndexFooterMarker) {
+      uint64_t indexOffset = footer[1];
+      indexOffset = (indexOffset << 32) + footer[0];
+      std::array<uint32_t, 2> indexHeader;
+      if(eventIndexFitsInFile(indexOffset, 0, fileSize)
+         and iFile.seekg(indexOffset) and iFile.read(reinterpret_cast<char*>(indexHeader.data()), 2*4)
+         and indexHeader[0] == kEventIndexRecordMarker and eventIndexFitsInFile(indexOffset, indexHeader[1], fileSize)) {
+        std::vector<uint32_t> words(indexHeader[1]*kEventIndexEntrySizeInWords);
+        iFile.read(reinterpret_cast<char*>(words.data()), words.size()*4);
+        if(iFile) {
+          index = eventIndexFromWords(words.data(), indexHeader[1]);
+        }
+      }
+    }
+  }
+  iFile.clear();
+  iFile.seekg(presentPosition);
+  return index;
+}
+
+std::vector<EventIndexEntry> pds::readEventIndex(char const* iFileBegin, size_t iFileSize) {
+  if(iFileSize < kEventIndexFooterSizeInWords*4) {
+    return {};
+  }
+  auto footer = reinterpret_cast<uint32_t const*>(iFileBegin+iFileSize-kEventIndexFooterSizeInWords*4);
+  if(footer[2] != kEventIndexFooterMarker) {
+    return {};
+  }
+  uint64_t indexOffset = footer[1];
+  indexOffset = (indexOffset << 32) + footer[0];
+  if(not eventIndexFitsInFile(indexOffset, 0, iFileSize)) {
+    return {};
+  }
+  auto indexHeader = reinterpret_cast<uint32_t const*>(iFileBegin+indexOffset);
+  if(indexHeader[0] != kEventIndexRecordMarker or not eventIndexFitsInFile(indexOffset, indexHeader[1], iFileSize)) {
+    return {};
+  }
+  return eventIndexFromWords(indexHeader+2, indexHeader[1]);
+}
+
 bool pds::readCompressedEventBuffer(std::istream&file, EventIdentifier& iEventID, std::vector<uint32_t>& buffer) {
   //header structure in words
   //constexpr size_t kTransitionTypeW=0;
@@ -174,6 +367,11 @@ bool pds::readCompressedEventBuffer(std::istream&file, EventIdentifier& iEventID
     return false;
   }
   assert(file.rdstate() == std::ios_base::goodbit);
+  if(headerBuffer[0] == kEventIndexRecordMarker) {
+    //reached the end of the events. Stay here so later calls also stop.
+    file.seekg(-int((kEventHeaderSizeInWords+1)*4), std::ios_base::cur);
+    return false;
+  }
 
   int32_t bufferSize = headerBuffer[kEventHeaderSizeInWords];
 
@@ -182,7 +380,10 @@ bool pds::readCompressedEventBuffer(std::istream&file, EventIdentifier& iEventID
   unsigned long long eventID = eventIDTopWord+headerBuffer[kEventIDLSW];
   iEventID = {headerBuffer[kRunIDW], headerBuffer[kLumiIDW], eventID};
 
-  buffer = readWords(file, bufferSize+1);
+  //reuse the memory already held by buffer
+  buffer.resize(bufferSize+1);
+  file.read(reinterpret_cast<char*>(buffer.data()), 4*(bufferSize+1));
+  assert(file.rdstate() == std::ios_base::goodbit);
 
   int32_t crossCheckBufferSize = buffer[bufferSize];
   //std::cout <<bufferSize<<" "<<crossCheckBufferSize<<std::endl;
@@ -190,9 +391,43 @@ bool pds::readCompressedEventBuffer(std::istream&file, EventIdentifier& iEventID
   return true;
 }
 
+bool pds::preadEventHeader(int iFileDescriptor, uint64_t iOffset, EventIdentifier& iEventID, uint32_t& oRecordSize) {
+  //header structure in words
+  //constexpr size_t kTransitionTypeW=0;
+  constexpr size_t kEventIDMSW=3;
+  constexpr size_t kEventIDLSW=4;
+  constexpr size_t kRunIDW=1;
+  constexpr size_t kLumiIDW=2;
+
+  std::array<uint32_t, kEventHeaderSizeInWords+1> headerBuffer;
+  auto nRead = preadFully(iFileDescriptor, reinterpret_cast<char*>(headerBuffer.data()), headerBuffer.size()*4, iOffset);
+  if(nRead != headerBuffer.size()*4 or headerBuffer[0] == kEventIndexRecordMarker) {
+    return false;
+  }
+  oRecordSize = headerBuffer[kEventHeaderSizeInWords];
+
+  unsigned long long eventIDTopWord = headerBuffer[kEventIDMSW];
+  eventIDTopWord = eventIDTopWord <<32;
+  unsigned long long eventID = eventIDTopWord+headerBuffer[kEventIDLSW];
+  iEventID = {headerBuffer[kRunIDW], headerBuffer[kLumiIDW], eventID};
+  return true;
+}
+
+void pds::preadCompressedEventBuffer(int iFileDescriptor, uint64_t iOffset, uint32_t iRecordSize, std::vector<uint32_t>& buffer) {
+  buffer.resize(iRecordSize+1);
+  auto nRead = preadFully(iFileDescriptor, reinterpret_cast<char*>(buffer.data()), buffer.size()*4, iOffset+(kEventHeaderSizeInWords+1)*4);
+  if(nRead != buffer.size()*4) {
+    throw std::runtime_error("file ends in the middle of an event record");
+  }
+  assert(buffer[iRecordSize] == iRecordSize);
+}
 
-std::vector<uint32_t> pds::uncompressEventBuffer(pds::Compression compression, std::vector<uint32_t> const& buffer) {
-  int32_t bufferSize = buffer.size();
+std::vector<uint32_t> pds::uncompressEventBuffer(pds::Compression compression, std::vector<uint32_t> const& buffer, ZSTD_DDict const* iDictionary) {
+  return uncompressEventBuffer(compression, buffer.data(), buffer.size(), iDictionary);
+}
+
+std::vector<uint32_t> pds::uncompressEventBuffer(pds::Compression compression, uint32_t const* buffer, size_t iBufferSize, ZSTD_DDict const* iDictionary) {
+  int32_t bufferSize = iBufferSize;
   //lower 2 bits are the number of bytes used in the last word of the compressed sized
   int32_t uncompressedBufferSize = buffer[0]/4;
   int32_t bytesInLastWord = buffer[0] % 4;
@@ -200,19 +435,144 @@ std::vector<uint32_t> pds::uncompressEventBuffer(pds::Compression compression, s
   //std::cout <<"compressed "<<compressedBufferSizeInBytes <<" uncompressed "<<uncompressedBufferSize*4<<" extra bytes "<<bytesInLastWord<<std::endl;
   std::vector<uint32_t> uBuffer(size_t(uncompressedBufferSize), 0);
   if(Compression::kLZ4 == compression) {
-    LZ4_decompress_safe(reinterpret_cast<char const*>(&(*(buffer.begin()+1))), reinterpret_cast<char*>(uBuffer.data()),
+    LZ4_decompress_safe(reinterpret_cast<char const*>(buffer+1), reinterpret_cast<char*>(uBuffer.data()),
                         compressedBufferSizeInBytes,
                         uncompressedBufferSize*4);
   } else if(Compression::kZSTD == compression) {
-    ZSTD_decompress(uBuffer.data(), uncompressedBufferSize*4, &(*(buffer.begin()+1)), compressedBufferSizeInBytes);
+    if(iDictionary) {
+      ZSTD_decompress_usingDDict(decompressionContext(), uBuffer.data(), uncompressedBufferSize*4, buffer+1, compressedBufferSizeInBytes, iDictionary);
+    } else {
+      ZSTD_decompressDCtx(decompressionContext(), uBuffer.data(), uncompressedBufferSize*4, buffer+1, compressedBufferSizeInBytes);
+    }
   } else if(Compression::kNone == compression) {
-    assert(buffer.size() == uBuffer.size()+2);
-    std::copy(buffer.begin()+1, buffer.begin()+buffer.size(), uBuffer.begin());
+    assert(iBufferSize == uBuffer.size()+1);
+    std::copy(buffer+1, buffer+iBufferSize, uBuffer.begin());
+  }
+  return uBuffer;
+}
+
+void pds::locateCompressedDataProducts(uint32_t const* iRecord, size_t iRecordSize, std::vector<CompressedProduct>& oProducts) {
+  for(auto& p: oProducts) {
+    p.size = 0;
+  }
+  uint32_t offset = 0;
+  while(offset < iRecordSize) {
+    auto productIndex = iRecord[offset++];
+    auto storedSize = iRecord[offset++];
+    bool isReference = storedSize & kProductReferenceBit;
+    storedSize &= ~kProductReferenceBit;
+    assert(productIndex < oProducts.size());
+    oProducts[productIndex] = {offset, storedSize, isReference};
+    offset += storedSize;
+  }
+  assert(offset == iRecordSize);
+}
+
+std::vector<uint32_t> pds::uncompressPerProductEventBuffer(pds::Compression compression, uint32_t const* iRecord, size_t iRecordSize, ZSTD_DDict const* iDictionary,
+                                                             ProductReferenceResolver const* iResolver) {
+  std::vector<uint32_t> uBuffer;
+  uint32_t const* it = iRecord;
+  uint32_t const* itEnd = iRecord+iRecordSize;
+  while(it < itEnd) {
+    auto productIndex = *(it++);
+    auto storedSize = *(it++);
+    uBuffer.push_back(productIndex);
+    if(storedSize & kProductReferenceBit) {
+      if(not iResolver) {
+        throw std::runtime_error("event record holds a data product reference but no resolver was given");
+      }
+      auto uProduct = iResolver->uncompressedProduct(productIndex, it);
+      uBuffer.push_back(uProduct->size());
+      uBuffer.insert(uBuffer.end(), uProduct->begin(), uProduct->end());
+      it += kProductReferenceSizeInWords;
+      continue;
+    }
+    auto uProduct = uncompressEventBuffer(compression, it, storedSize, iDictionary);
+    uBuffer.push_back(uProduct.size());
+    uBuffer.insert(uBuffer.end(), uProduct.begin(), uProduct.end());
+    it += storedSize;
   }
+  assert(it == itEnd);
   return uBuffer;
 }
 
-void pds::deserializeDataProducts(buffer_iterator it, buffer_iterator itEnd, std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers) {
+pds::ProductReferenceResolver::ProductReferenceResolver(std::string const& iFileName, Compression iCompression, ZSTD_DDict const* iDictionary, size_t iNDataProducts):
+  fileDescriptor_{open(iFileName.c_str(), O_RDONLY)},
+  compression_{iCompression},
+  dictionary_{iDictionary},
+  cache_(iNDataProducts)
+{
+  if(fileDescriptor_ < 0) {
+    throw std::runtime_error("unable to open file "+iFileName);
+  }
+}
+
+pds::ProductReferenceResolver::~ProductReferenceResolver() {
+  close(fileDescriptor_);
+}
+
+std::shared_ptr<std::vector<uint32_t> const> pds::ProductReferenceResolver::uncompressedProduct(uint32_t iProductIndex, uint32_t const* iReference) const {
+  uint64_t recordOffset = iReference[1];
+  recordOffset = (recordOffset << 32) + iReference[0];
+  assert(iProductIndex < cache_.size());
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto const& cached = cache_[iProductIndex];
+    if(cached.product_ and cached.recordOffset_ == recordOffset) {
+      return cached.product_;
+    }
+  }
+
+  EventIdentifier id;
+  uint32_t recordSize;
+  if(not preadEventHeader(fileDescriptor_, recordOffset, id, recordSize)) {
+    throw std::runtime_error("data product reference does not point to an event record");
+  }
+  std::vector<uint32_t> record;
+  preadCompressedEventBuffer(fileDescriptor_, recordOffset, recordSize, record);
+  record.pop_back();
+  std::vector<CompressedProduct> products(cache_.size());
+  locateCompressedDataProducts(record.data(), record.size(), products);
+  auto const& product = products[iProductIndex];
+  if(product.size == 0 or product.isReference) {
+    throw std::runtime_error("data product reference does not point to a stored data product");
+  }
+  auto uProduct = std::make_shared<std::vector<uint32_t> const>(uncompressEventBuffer(compression_, record.data()+product.offset, product.size, dictionary_));
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  cache_[iProductIndex] = {recordOffset, uProduct};
+  return uProduct;
+}
+
+std::vector<EventIdentifier> pds::readColumnarBatch(uint32_t const* iRecord, size_t iRecordSize, std::vector<CompressedProduct>& oColumns) {
+  assert(iRecordSize > 0);
+  uint32_t nEvents = iRecord[0];
+  size_t columnsStart = 1+nEvents*kEventIdentifierSizeInWords;
+  assert(columnsStart <= iRecordSize);
+  std::vector<EventIdentifier> eventIDs;
+  eventIDs.reserve(nEvents);
+  for(uint32_t const* it = iRecord+1; it != iRecord+columnsStart; it += kEventIdentifierSizeInWords) {
+    unsigned long long event = it[2];
+    event = (event << 32) + it[3];
+    eventIDs.push_back({it[0], it[1], event});
+  }
+  locateCompressedDataProducts(iRecord+columnsStart, iRecordSize-columnsStart, oColumns);
+  for(auto& c: oColumns) {
+    c.offset += columnsStart;
+  }
+  return eventIDs;
+}
+
+void pds::deserializeDataProducts(buffer_iterator it, buffer_iterator itEnd, std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers,
+                                  unsigned int iLane) {
+  if(it == itEnd) {
+    return;
+  }
+  deserializeDataProducts(&(*it), &(*it) + (itEnd-it), dataProducts, deserializers, iLane);
+}
+
+void pds::deserializeDataProducts(uint32_t const* it, uint32_t const* itEnd, std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers,
+                                  unsigned int iLane) {
 
   while(it < itEnd) {
     auto productIndex = *(it++);
@@ -221,7 +581,7 @@ void pds::deserializeDataProducts(buffer_iterator it, buffer_iterator itEnd, std
 
     //std::cout <<dataProducts[productIndex].name()<<" "<<dataProducts[productIndex].classType()->GetName()<<std::endl;
     //std::cout <<"storedSize "<<storedSize<<" "<<storedSize*4<<std::endl;
-    auto readSize = deserializers[productIndex].deserialize(reinterpret_cast<char const*>(&*it), storedSize*4, *dataProducts[productIndex].address());
+    auto readSize = deserializers[productIndex].deserialize(iLane, reinterpret_cast<char const*>(it), storedSize*4, *dataProducts[productIndex].address());
     dataProducts[productIndex].setSize(readSize);
     //std::cout <<" readSize "<<readSize<<"\n";
 
@@ -247,7 +607,7 @@ std::vector<char> pds::uncompressBuffer(pds::Compression compression, std::vecto
     }
     assert(size == uncompressedBufferSize);
   } else if(Compression::kZSTD == compression) {
-    ZSTD_decompress(uBuffer.data(), uncompressedBufferSize, &(*(buffer.begin())), buffer.size());
+    ZSTD_decompressDCtx(decompressionContext(), uBuffer.data(), uncompressedBufferSize, &(*(buffer.begin())), buffer.size());
   } else if(Compression::kNone == compression) {
     assert(buffer.size() == uBuffer.size());
     std::copy(buffer.begin(), buffer.begin()+buffer.size(), uBuffer.begin());
@@ -257,7 +617,7 @@ std::vector<char> pds::uncompressBuffer(pds::Compression compression, std::vecto
 
 void pds::deserializeDataProducts(const char* it, const char* itEnd, 
                                   table_iterator itTable, table_iterator itTableEnd,
-                                  std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers) {
+                                  std::vector<DataProductRetriever>& dataProducts, DeserializeStrategy const& deserializers, unsigned int iLane) {
 
   auto itBegin = it;
   uint32_t productIndex = 0;
@@ -270,7 +630,7 @@ void pds::deserializeDataProducts(const char* it, const char* itEnd,
 
       //std::cout <<dataProducts[productIndex].name()<<" "<<dataProducts[productIndex].classType()->GetName()<<std::endl;
       //std::cout <<"storedSize "<<storedSize<<" "<<storedSize*4<<std::endl;
-      auto readSize = deserializers[productIndex].deserialize(it, storedSize, *dataProducts[productIndex].address());
+      auto readSize = deserializers[productIndex].deserialize(iLane, it, storedSize, *dataProducts[productIndex].address());
       dataProducts[productIndex].setSize(readSize);
       //std::cout <<" readSize "<<readSize<<"\n";
 
@@ -284,11 +644,16 @@ void pds::deserializeDataProducts(const char* it, const char* itEnd,
 
 
 bool pds::skipToNextEvent(std::istream& iFile) {
-  iFile.seekg(kEventHeaderSizeInWords*4, std::ios_base::cur);
+  uint32_t recordType = readwordNoCheck(iFile);
   if( iFile.rdstate() & std::ios_base::eofbit) {
     return false;
   }
   assert(iFile.rdstate() == std::ios_base::goodbit);
+  if(recordType == kEventIndexRecordMarker) {
+    iFile.seekg(-4, std::ios_base::cur);
+    return false;
+  }
+  iFile.seekg((kEventHeaderSizeInWords-1)*4, std::ios_base::cur);
 
   int32_t bufferSize = readwordNoCheck(iFile);
   if( iFile.rdstate() & std::ios_base::eofbit) {
@@ -3,6 +3,11 @@
 
 #include <istream>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "zstd.h"
 
 #include "DeserializeStrategy.h"
 #include "EventIdentifier.h"
@@ -31,17 +36,104 @@ namespace cce::tf::pds {
   };
   
   std::vector<ProductInfo> readFileHeader(std::istream&, Compression&, Serialization&);
+  //oDictionary is empty if the file was not compressed using a dictionary
+  //oFlags holds the kFile* bits from pds_common.h
+  //oLayoutFingerprint is 0 unless the file has kFileHasLayoutFingerprint set
+  std::vector<ProductInfo> readFileHeader(std::istream&, Compression&, Serialization&, std::vector<char>& oDictionary, uint32_t& oFlags,
+                                          uint64_t& oLayoutFingerprint);
+
+  struct DecompressionDictionaryDeleter {
+    void operator()(ZSTD_DDict* iDict) const { ZSTD_freeDDict(iDict); }
+  };
+  using DecompressionDictionary = std::unique_ptr<ZSTD_DDict, DecompressionDictionaryDeleter>;
+  //returns a null dictionary if iDictionary is empty
+  DecompressionDictionary makeDecompressionDictionary(std::vector<char> const& iDictionary);
+
+  //throws if a kRaw file was written using a different data layout than this job would use
+  void checkLayoutFingerprint(Serialization, std::vector<ProductInfo> const&, uint64_t iLayoutFingerprint);
 
-  constexpr size_t kEventHeaderSizeInWords = 5;
+  //one deserializer per data product, in the same order as the ProductInfo. The
+  // deserializers can be used concurrently by iNLanes lanes so one strategy can be shared by all lanes.
+  DeserializeStrategy makeDeserializeStrategy(Serialization, std::vector<ProductInfo> const&, unsigned int iNLanes);
+
+  //returns an empty vector if the file has no event index. The stream position is unchanged.
+  std::vector<EventIndexEntry> readEventIndex(std::istream&);
+  std::vector<EventIndexEntry> readEventIndex(char const* iFileBegin, size_t iFileSize);
   bool skipToNextEvent(std::istream&); //returns true if an event was skipped
   bool readCompressedEventBuffer(std::istream&, EventIdentifier&, std::vector<uint32_t>& buffer);
-  std::vector<uint32_t> uncompressEventBuffer(pds::Compression, std::vector<uint32_t> const& buffer);
-  void deserializeDataProducts(std::vector<uint32_t>::const_iterator, std::vector<uint32_t>::const_iterator, std::vector<DataProductRetriever>&, DeserializeStrategy const&);
+
+  //Positional reads from a file descriptor which can be done concurrently.
+  //returns false if there is no event record at iOffset
+  bool preadEventHeader(int iFileDescriptor, uint64_t iOffset, EventIdentifier&, uint32_t& oRecordSize);
+  //buffer is filled the same as readCompressedEventBuffer, i.e. the last word is the crosscheck size
+  void preadCompressedEventBuffer(int iFileDescriptor, uint64_t iOffset, uint32_t iRecordSize, std::vector<uint32_t>& buffer);
+  std::vector<uint32_t> uncompressEventBuffer(pds::Compression, std::vector<uint32_t> const& buffer, ZSTD_DDict const* iDictionary = nullptr);
+  //buffer is the compressed record as stored in the file without the trailing crosscheck word
+  std::vector<uint32_t> uncompressEventBuffer(pds::Compression, uint32_t const* buffer, size_t bufferSize, ZSTD_DDict const* iDictionary = nullptr);
+
+  //Layout of an event record in a file with kFileHasPerProductCompression. For each data product:
+  // the product index, the number of words n used by the compressed product, then those n words.
+  // The first of the n words holds the same size information as the first word of a record which
+  // was compressed as a whole so each product can be passed to uncompressEventBuffer.
+  // If the file has kFileHasProductReferences, the number of words may have kProductReferenceBit
+  // set. The words then hold the file offset of the event record storing the data product.
+  struct CompressedProduct {
+    //offset in words from the start of the record
+    uint32_t offset = 0;
+    //0 if the product is not in the record
+    uint32_t size = 0;
+    //the words are a reference which must be passed to a ProductReferenceResolver
+    bool isReference = false;
+  };
+  //oProducts must already be sized to the number of data products in the file
+  void locateCompressedDataProducts(uint32_t const* iRecord, size_t iRecordSize, std::vector<CompressedProduct>& oProducts);
+
+  //Reads the data products referred to by event records of files with kFileHasProductReferences.
+  // It uses its own file descriptor and positional reads so it can be used concurrently. The last
+  // data product read for each product index is kept as the following references usually point to it.
+  class ProductReferenceResolver {
+  public:
+    ProductReferenceResolver(std::string const& iFileName, Compression, ZSTD_DDict const* iDictionary, size_t iNDataProducts);
+    ~ProductReferenceResolver();
+    ProductReferenceResolver(ProductReferenceResolver const&) = delete;
+    ProductReferenceResolver& operator=(ProductReferenceResolver const&) = delete;
+
+    //iReference points to the kProductReferenceSizeInWords words stored in the record.
+    // Returns the uncompressed data product.
+    std::shared_ptr<std::vector<uint32_t> const> uncompressedProduct(uint32_t iProductIndex, uint32_t const* iReference) const;
+  private:
+    struct Cached {
+      uint64_t recordOffset_ = 0;
+      std::shared_ptr<std::vector<uint32_t> const> product_;
+    };
+    int fileDescriptor_;
+    Compression compression_;
+    ZSTD_DDict const* dictionary_;
+    mutable std::mutex mutex_;
+    mutable std::vector<Cached> cache_;
+  };
+
+  //returns the same layout as uncompressEventBuffer so it can be passed to deserializeDataProducts
+  //iResolver is only needed if the file has kFileHasProductReferences
+  std::vector<uint32_t> uncompressPerProductEventBuffer(pds::Compression, uint32_t const* iRecord, size_t iRecordSize, ZSTD_DDict const* iDictionary = nullptr,
+                                                        ProductReferenceResolver const* iResolver = nullptr);
+
+  //Layout of a columnar batch record. The record header holds kColumnarBatchRecordType and the
+  // identifier of the first event. The record holds the number of events n, the n event identifiers,
+  // then one column per data product using the per product layout above. An uncompressed column
+  // holds n+1 offsets, in words after the offsets, of where each event's data product begins followed
+  // by the data products of all the events.
+  //oColumns is filled the same as locateCompressedDataProducts with offsets from the start of the record
+  std::vector<EventIdentifier> readColumnarBatch(uint32_t const* iRecord, size_t iRecordSize, std::vector<CompressedProduct>& oColumns);
+
+  void deserializeDataProducts(std::vector<uint32_t>::const_iterator, std::vector<uint32_t>::const_iterator, std::vector<DataProductRetriever>&, DeserializeStrategy const&,
+                               unsigned int iLane);
+  void deserializeDataProducts(uint32_t const* iBegin, uint32_t const* iEnd, std::vector<DataProductRetriever>&, DeserializeStrategy const&, unsigned int iLane);
 
   std::vector<char> uncompressBuffer(pds::Compression, std::vector<char> const& buffer, uint32_t uncompressedSize);
   void deserializeDataProducts(const char* iBufferBegin, const char* iBufferEnd, 
                                std::vector<uint32_t>::const_iterator itTableBegin, std::vector<uint32_t>::const_iterator itTableEnd, 
-                               std::vector<DataProductRetriever>&, DeserializeStrategy const&);
+                               std::vector<DataProductRetriever>&, DeserializeStrategy const&, unsigned int iLane);
 
 }
 
@@ -1,108 +1,222 @@
 #include "pds_writer.h"
 #include <algorithm>
 #include <iostream>
+#include <memory>
 
 #include "lz4.h"
 #include "zstd.h"
+#include "zdict.h"
 
 namespace {
   static inline size_t bytesToWords(size_t nBytes) {
     return nBytes/4 + ( (nBytes % 4) == 0 ? 0 : 1);
   }
+
+  //Creating a compression context is expensive compared to compressing a small event
+  // so each thread keeps its own and reuses it for every call.
+  class CompressionContexts {
+  public:
+    CompressionContexts(): zstd_(ZSTD_createCCtx()), lz4State_(new uint64_t[(LZ4_sizeofState()+7)/8]) {}
+    ~CompressionContexts() { ZSTD_freeCCtx(zstd_); }
+    CompressionContexts(CompressionContexts const&) = delete;
+    CompressionContexts& operator=(CompressionContexts const&) = delete;
+
+    ZSTD_CCtx* zstd(int iCompressionLevel) {
+      if(iCompressionLevel != zstdLevel_) {
+        ZSTD_CCtx_setParameter(zstd_, ZSTD_c_compressionLevel, iCompressionLevel);
+        zstdLevel_ = iCompressionLevel;
+      }
+      return zstd_;
+    }
+    //the dictionary carries its own compression level
+    ZSTD_CCtx* zstd() { return zstd_; }
+    void* lz4() { return lz4State_.get(); }
+  private:
+    ZSTD_CCtx* zstd_;
+    int zstdLevel_ = ZSTD_CLEVEL_DEFAULT;
+    //LZ4 requires the state to be 8 byte aligned
+    std::unique_ptr<uint64_t[]> lz4State_;
+  };
+
+  CompressionContexts& compressionContexts() {
+    static thread_local CompressionContexts s_contexts;
+    return s_contexts;
+  }
+
+  int lz4Compress(char const* iSource, char* iDestination, int iSourceSize, int iCapacity) {
+    return LZ4_compress_fast_extState(compressionContexts().lz4(), iSource, iDestination, iSourceSize, iCapacity, 1);
+  }
+
+  size_t zstdCompress(void* iDestination, size_t iCapacity, void const* iSource, size_t iSourceSize, int iCompressionLevel) {
+    return ZSTD_compress2(compressionContexts().zstd(iCompressionLevel), iDestination, iCapacity, iSource, iSourceSize);
+  }
   
-  std::pair<std::vector<uint32_t>,int> lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer) {
+  //the compressed buffers are filled in place so the caller can reuse their memory
+  int lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, uint32_t const* iBuffer, size_t iBufferSize, std::vector<uint32_t>& cBuffer) {
     int cSize = 0;
-    auto const bound = LZ4_compressBound(iBuffer.size()*4);
-    std::vector<uint32_t> cBuffer(bytesToWords(size_t(bound))+iLeadPadding+iTrailingPadding, 0);
-    cSize = LZ4_compress_default(reinterpret_cast<char const*>(&(*iBuffer.begin())), reinterpret_cast<char*>(&(*(cBuffer.begin()+iLeadPadding))), iBuffer.size()*4, bound);
+    auto const bound = LZ4_compressBound(iBufferSize*4);
+    cBuffer.clear();
+    cBuffer.resize(bytesToWords(size_t(bound))+iLeadPadding+iTrailingPadding, 0);
+    cSize = lz4Compress(reinterpret_cast<char const*>(iBuffer), reinterpret_cast<char*>(&(*(cBuffer.begin()+iLeadPadding))), iBufferSize*4, bound);
     cBuffer.resize(bytesToWords(cSize)+iLeadPadding+iTrailingPadding);
-    return {cBuffer,cSize};
+    return cSize;
   }
   
-  std::pair<std::vector<uint32_t>, int> noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer) {
+  int noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, uint32_t const* iBuffer, size_t iBufferSize, std::vector<uint32_t>& cBuffer) {
     int cSize = 0;
-    auto const bound = iBuffer.size()*4;
-    std::vector<uint32_t> cBuffer(iBuffer.size()+iLeadPadding+iTrailingPadding, uint32_t(0));
+    auto const bound = iBufferSize*4;
+    cBuffer.clear();
+    cBuffer.resize(iBufferSize+iLeadPadding+iTrailingPadding, uint32_t(0));
     cSize = bound;
-    std::copy(iBuffer.begin(), iBuffer.end(), cBuffer.begin()+iLeadPadding);
-    return {cBuffer, cSize};
+    std::copy(iBuffer, iBuffer+iBufferSize, cBuffer.begin()+iLeadPadding);
+    return cSize;
   }
   
-  std::pair<std::vector<uint32_t>, int> zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<uint32_t> const& iBuffer, int compressionLevel) {
+  int zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, uint32_t const* iBuffer, size_t iBufferSize, int compressionLevel,
+                         ZSTD_CDict const* iDictionary, std::vector<uint32_t>& cBuffer) {
     int cSize = 0;
-    auto const bound = ZSTD_compressBound(iBuffer.size()*4);
-    std::vector<uint32_t> cBuffer(bytesToWords(size_t(bound))+iLeadPadding+iTrailingPadding, 0);
-    cSize = ZSTD_compress(&(*(cBuffer.begin()+iLeadPadding)), bound, &(*iBuffer.begin()),  iBuffer.size()*4, compressionLevel);
+    auto const bound = ZSTD_compressBound(iBufferSize*4);
+    cBuffer.clear();
+    cBuffer.resize(bytesToWords(size_t(bound))+iLeadPadding+iTrailingPadding, 0);
+    if(iDictionary) {
+      //the compression level was set when the dictionary was made
+      cSize = ZSTD_compress_usingCDict(compressionContexts().zstd(), &(*(cBuffer.begin()+iLeadPadding)), bound, iBuffer, iBufferSize*4, iDictionary);
+    } else {
+      cSize = zstdCompress(&(*(cBuffer.begin()+iLeadPadding)), bound, iBuffer,  iBufferSize*4, compressionLevel);
+    }
     if(ZSTD_isError(cSize)) {
       std::cout <<"ERROR in comparession "<<ZSTD_getErrorName(cSize)<<std::endl;
     }
     cBuffer.resize(bytesToWords(cSize)+iLeadPadding+iTrailingPadding);
-    return {cBuffer,cSize};
+    return cSize;
   }
 
 
-  std::vector<char> lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer) {
+  void lz4CompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer, std::vector<char>& cBuffer) {
     auto const bound = LZ4_compressBound(iBuffer.size());
-    std::vector<char> cBuffer(bound+iLeadPadding+iTrailingPadding, 0);
-    auto cSize = LZ4_compress_default(&(*iBuffer.begin()), &(*(cBuffer.begin()+iLeadPadding)), iBuffer.size(), bound);
+    cBuffer.clear();
+    cBuffer.resize(bound+iLeadPadding+iTrailingPadding, 0);
+    auto cSize = lz4Compress(&(*iBuffer.begin()), &(*(cBuffer.begin()+iLeadPadding)), iBuffer.size(), bound);
     cBuffer.resize(cSize+iLeadPadding+iTrailingPadding);
-    return cBuffer;
   }
   
-  std::vector<char> noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer) {
-    std::vector<char> cBuffer(iBuffer.size()+iLeadPadding+iTrailingPadding, uint32_t(0));
+  void noCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer, std::vector<char>& cBuffer) {
+    cBuffer.clear();
+    cBuffer.resize(iBuffer.size()+iLeadPadding+iTrailingPadding, uint32_t(0));
     std::copy(iBuffer.begin(), iBuffer.end(), cBuffer.begin()+iLeadPadding);
-    return cBuffer;
   }
   
-  std::vector<char> zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer, int compressionLevel) {
+  void zstdCompressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, std::vector<char> const& iBuffer, int compressionLevel, std::vector<char>& cBuffer) {
     int cSize = 0;
     auto const bound = ZSTD_compressBound(iBuffer.size());
-    std::vector<char> cBuffer(bound+iLeadPadding+iTrailingPadding, 0);
-    cSize = ZSTD_compress(&(*(cBuffer.begin()+iLeadPadding)), bound, &(*iBuffer.begin()),  iBuffer.size(), compressionLevel);
+    cBuffer.clear();
+    cBuffer.resize(bound+iLeadPadding+iTrailingPadding, 0);
+    cSize = zstdCompress(&(*(cBuffer.begin()+iLeadPadding)), bound, &(*iBuffer.begin()),  iBuffer.size(), compressionLevel);
     if(ZSTD_isError(cSize)) {
       std::cout <<"ERROR in comparession "<<ZSTD_getErrorName(cSize)<<std::endl;
     }
     cBuffer.resize(cSize+iLeadPadding+iTrailingPadding);
-    return cBuffer;
   }
 
+  //the splitmix64 finalizer
+  inline uint64_t mix(uint64_t iValue) {
+    iValue ^= iValue >> 30;
+    iValue *= 0xBF58476D1CE4E5B9ULL;
+    iValue ^= iValue >> 27;
+    iValue *= 0x94D049BB133111EBULL;
+    return iValue ^ (iValue >> 31);
+  }
 }
 
 namespace cce::tf::pds {
+
+  uint64_t hashWords(uint32_t const* iData, size_t iSizeInWords) {
+    uint64_t hash = mix(0x9E3779B97F4A7C15ULL ^ iSizeInWords);
+    size_t i = 0;
+    for(; i+1 < iSizeInWords; i += 2) {
+      hash = mix(hash ^ ((static_cast<uint64_t>(iData[i+1]) << 32) | iData[i]));
+    }
+    if(i < iSizeInWords) {
+      hash = mix(hash ^ iData[i]);
+    }
+    return hash;
+  }
+
+  std::vector<char> trainDictionary(std::vector<std::vector<uint32_t>> const& iSamples, size_t iMaxDictionarySize) {
+    std::vector<char> samples;
+    std::vector<size_t> sampleSizes;
+    sampleSizes.reserve(iSamples.size());
+    for(auto const& s: iSamples) {
+      auto begin = reinterpret_cast<char const*>(s.data());
+      samples.insert(samples.end(), begin, begin+s.size()*4);
+      sampleSizes.push_back(s.size()*4);
+    }
+    std::vector<char> dictionary(iMaxDictionarySize);
+    auto size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(), samples.data(), sampleSizes.data(), sampleSizes.size());
+    if(ZDICT_isError(size)) {
+      std::cout <<"unable to train dictionary: "<<ZDICT_getErrorName(size)<<std::endl;
+      return {};
+    }
+    dictionary.resize(size);
+    return dictionary;
+  }
+
+  CompressionDictionary makeCompressionDictionary(std::vector<char> const& iDictionary, int iCompressionLevel) {
+    return CompressionDictionary(ZSTD_createCDict(iDictionary.data(), iDictionary.size(), iCompressionLevel));
+  }
   
-  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<uint32_t> const& iBuffer) {
+  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<uint32_t> const& iBuffer,
+                                                       ZSTD_CDict const* iDictionary) {
+    return compressBuffer(iLeadPadding, iTrailingPadding, iAlgorithm, iCompressionLevel, iBuffer.data(), iBuffer.size(), iDictionary);
+  }
+
+  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, 
+                                                       uint32_t const* iBuffer, size_t iBufferSize, ZSTD_CDict const* iDictionary) {
+    std::vector<uint32_t> cBuffer;
+    auto cSize = compressBuffer(iLeadPadding, iTrailingPadding, iAlgorithm, iCompressionLevel, iBuffer, iBufferSize, cBuffer, iDictionary);
+    return {std::move(cBuffer), cSize};
+  }
+
+  int compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, 
+                     uint32_t const* iBuffer, size_t iBufferSize, std::vector<uint32_t>& oCompressed, ZSTD_CDict const* iDictionary) {
 
     switch(iAlgorithm) {
     case Compression::kLZ4 : {
-      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer);
+      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer, iBufferSize, oCompressed);
     }    
     case Compression::kNone : {
-      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
+      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iBufferSize, oCompressed);
     } 
     case Compression::kZSTD : {
-      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel);
+      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iBufferSize, iCompressionLevel, iDictionary, oCompressed);
     }
     default:
-      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
+      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iBufferSize, oCompressed);
       
     }
   }
 
   std::vector<char> compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char> const& iBuffer) {
+    std::vector<char> cBuffer;
+    compressBuffer(iLeadPadding, iTrailingPadding, iAlgorithm, iCompressionLevel, iBuffer, cBuffer);
+    return cBuffer;
+  }
+
+  void compressBuffer(unsigned int iLeadPadding, unsigned int iTrailingPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char> const& iBuffer,
+                      std::vector<char>& oCompressed) {
 
     switch(iAlgorithm) {
     case Compression::kLZ4 : {
-      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer);
+      return lz4CompressBuffer(iLeadPadding,iTrailingPadding, iBuffer, oCompressed);
     }    
     case Compression::kNone : {
-      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
+      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, oCompressed);
     } 
     case Compression::kZSTD : {
-      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel);
+      return zstdCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, iCompressionLevel, oCompressed);
     }
     default:
-      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer);
+      return noCompressBuffer(iLeadPadding, iTrailingPadding, iBuffer, oCompressed);
       
     }
   }
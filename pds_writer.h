@@ -6,12 +6,37 @@
 #include <utility>
 #include <vector>
 #include <cstdint>
+#include <memory>
+
+#include "zstd.h"
 
 namespace cce::tf::pds {
 
-  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<uint32_t> const& iBuffer);
+  struct CompressionDictionaryDeleter {
+    void operator()(ZSTD_CDict* iDict) const { ZSTD_freeCDict(iDict); }
+  };
+  using CompressionDictionary = std::unique_ptr<ZSTD_CDict, CompressionDictionaryDeleter>;
+
+  //returns an empty vector if a dictionary could not be made from the samples
+  std::vector<char> trainDictionary(std::vector<std::vector<uint32_t>> const& iSamples, size_t iMaxDictionarySize);
+  CompressionDictionary makeCompressionDictionary(std::vector<char> const& iDictionary, int iCompressionLevel);
+
+  //iDictionary is only used by ZSTD
+  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<uint32_t> const& iBuffer,
+                                                       ZSTD_CDict const* iDictionary = nullptr);
+  std::pair<std::vector<uint32_t>, int> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, 
+                                                       uint32_t const* iBuffer, size_t iBufferSize, ZSTD_CDict const* iDictionary = nullptr);
+
+  //same as above but fills oCompressed, reusing the memory it already holds, and returns the compressed size
+  int compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, 
+                     uint32_t const* iBuffer, size_t iBufferSize, std::vector<uint32_t>& oCompressed, ZSTD_CDict const* iDictionary = nullptr);
+
+  //fast non-cryptographic hash used to find data products which did not change between events
+  uint64_t hashWords(uint32_t const* iData, size_t iSizeInWords);
 
   std::vector<char> compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char> const& iBuffer);
+  void compressBuffer(unsigned int iReserveFirstNWords, unsigned int iPadding, Compression iAlgorithm, int iCompressionLevel, std::vector<char> const& iBuffer,
+                      std::vector<char>& oCompressed);
 
 }
 
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "CLI11.hpp"
+
+#include "SerialTaskQueue.h"
+
+#include "tbb/task_group.h"
+#include "tbb/global_control.h"
+#include "tbb/task_arena.h"
+
+namespace {
+  using namespace cce::tf;
+
+  struct Result {
+    std::chrono::microseconds wallTime;
+    //summed over all tasks, from the push to the start of the task
+    std::chrono::nanoseconds handOffTime;
+  };
+
+  //each producer pushes its next task once the previous one has run, the way a Lane waits for
+  // its event to be written before starting the next
+  Result run(SerialTaskQueue::Mode iMode, unsigned int iNProducers, unsigned int iNTasksPerProducer, unsigned int iWork) {
+    SerialTaskQueue queue(iMode);
+    std::vector<tbb::task_group> groups(iNProducers);
+    std::atomic<long long> handOffTime{0};
+    std::atomic<unsigned int> nFinished{0};
+    //only modified from within the queue
+    unsigned long long counter = 0;
+
+    struct Producer {
+      SerialTaskQueue* queue_;
+      tbb::task_group* group_;
+      std::atomic<long long>* handOffTime_;
+      std::atomic<unsigned int>* nFinished_;
+      unsigned long long* counter_;
+      unsigned int nLeft_;
+      unsigned int work_;
+
+      void pushNext() {
+        --nLeft_;
+        auto pushTime = std::chrono::high_resolution_clock::now();
+        queue_->push(*group_, [this, pushTime]() {
+            *handOffTime_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - pushTime).count();
+            for(unsigned int i=0; i<work_; ++i) {
+              ++(*counter_);
+            }
+            if(nLeft_ == 0) {
+              ++(*nFinished_);
+            } else {
+              group_->run([this]() { pushNext(); });
+            }
+          });
+      }
+    };
+    std::vector<Producer> producers;
+    producers.reserve(iNProducers);
+    for(unsigned int i=0; i<iNProducers; ++i) {
+      producers.push_back({&queue, &groups[i], &handOffTime, &nFinished, &counter, iNTasksPerProducer, iWork});
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for(auto& p: producers) {
+      p.group_->run([&p]() { p.pushNext(); });
+    }
+    //tasks run by the combining thread of another group can add to a group which was already waited on
+    do {
+      for(auto& g: groups) {
+        g.wait();
+      }
+    } while(nFinished != iNProducers);
+    for(auto& g: groups) {
+      g.wait();
+    }
+    Result r{std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start),
+        std::chrono::nanoseconds(handOffTime.load())};
+    if(counter != static_cast<unsigned long long>(iNProducers)*iNTasksPerProducer*iWork) {
+      std::cout <<"ERROR: wrong number of tasks run "<<counter<<std::endl;
+      exit(1);
+    }
+    return r;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  CLI::App app{"compare the SerialTaskQueue modes under contention"};
+
+  int parallelism = tbb::this_task_arena::max_concurrency();
+  app.add_option("-t,--num-threads", parallelism, "number of threads to use.\nDefault is all cores on the machine.");
+
+  unsigned int nProducers = 0;
+  app.add_option("-p,--num-producers", nProducers, "number of concurrent producers pushing to the queue.\nDefault is number of threads.");
+
+  unsigned int nTasks = 10000;
+  app.add_option("-n,--num-tasks", nTasks, "number of tasks pushed by each producer.\nDefault is 10000.");
+
+  unsigned int work = 10;
+  app.add_option("-w,--work", work, "number of increments done by each task.\nDefault is 10.");
+
+  CLI11_PARSE(app, argc, argv);
+
+  if(nTasks == 0) {
+    std::cout <<"the number of tasks must be at least 1"<<std::endl;
+    return 1;
+  }
+  if(nProducers == 0) {
+    nProducers = parallelism;
+  }
+
+  tbb::global_control c(tbb::global_control::max_allowed_parallelism, parallelism);
+  tbb::task_arena arena(parallelism);
+
+  std::cout <<"# threads "<<parallelism<<" # producers "<<nProducers<<" # tasks per producer "<<nTasks<<" work "<<work<<"\n";
+  for(auto mode: {SerialTaskQueue::Mode::kSpawn, SerialTaskQueue::Mode::kCombining}) {
+    Result r;
+    arena.execute([&]() { r = run(mode, nProducers, nTasks, work); });
+    auto nTotal = static_cast<double>(nProducers)*nTasks;
+    std::cout <<(mode == SerialTaskQueue::Mode::kSpawn ? "spawn    " : "combining")
+              <<" time: "<<r.wallTime.count()<<"us"
+              <<" per task: "<<1000.*r.wallTime.count()/nTotal<<"ns"
+              <<" average hand off: "<<r.handOffTime.count()/nTotal<<"ns\n";
+  }
+}
@@ -0,0 +1,67 @@
+#include "SpecializedSerializer.h"
+
+#include "cms/EventAuxiliary.h"
+#include "test_classes/TestClasses.h"
+
+//Member layouts of the classes which have a specialized serializer. The members must be
+// listed in the order they are declared.
+namespace cce::tf::specialized {
+  template<int I>
+  struct Layout<edm::Hash<I>> {
+    static constexpr auto members = std::make_tuple(&edm::Hash<I>::hash_);
+  };
+
+  template<>
+  struct Layout<edm::EventID> {
+    static constexpr auto members = std::make_tuple(&edm::EventID::run_, &edm::EventID::luminosityBlock_, &edm::EventID::event_);
+  };
+
+  template<>
+  struct Layout<edm::Timestamp> {
+    static constexpr auto members = std::make_tuple(&edm::Timestamp::timeLow_, &edm::Timestamp::timeHigh_);
+  };
+
+  template<>
+  struct Layout<edm::EventAuxiliary> {
+    using A = edm::EventAuxiliary;
+    static constexpr auto members = std::make_tuple(&A::processHistoryID_, &A::id_, &A::processGUID_, &A::time_,
+                                                    &A::luminosityBlock_, &A::isRealData_, &A::experimentType_,
+                                                    &A::bunchCrossing_, &A::orbitNumber_, &A::storeNumber_);
+  };
+
+  template<>
+  struct Layout<test::SimpleClass> {
+    static constexpr auto members = std::make_tuple(&test::SimpleClass::m_int);
+  };
+
+  template<>
+  struct Layout<test::TestClass> {
+    static constexpr auto members = std::make_tuple(&test::TestClass::m_string, &test::TestClass::m_float);
+  };
+
+  template<>
+  struct Layout<test::TestClassWithFloatVector> {
+    static constexpr auto members = std::make_tuple(&test::TestClassWithFloatVector::m_floats);
+  };
+
+  //a sample with values in every member so the self check covers them
+  template<>
+  struct Sample<edm::EventAuxiliary> {
+    static edm::EventAuxiliary* make() {
+      return new edm::EventAuxiliary({1, 2, 3}, "sample", edm::Timestamp{4}, true, edm::EventAuxiliary::PhysicsTrigger, 5, 6, 7);
+    }
+  };
+
+  template<>
+  struct Sample<test::TestClassWithFloatVector> {
+    static test::TestClassWithFloatVector* make() { return new test::TestClassWithFloatVector({1.f, 2.f, 3.f}); }
+  };
+}
+
+namespace {
+  using namespace cce::tf;
+  specialized::Registration<edm::EventAuxiliary> s_eventAuxiliary;
+  specialized::Registration<test::SimpleClass> s_simpleClass;
+  specialized::Registration<test::TestClass> s_testClass;
+  specialized::Registration<test::TestClassWithFloatVector> s_testClassWithFloatVector;
+}
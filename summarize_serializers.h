@@ -13,8 +13,11 @@ inline void summarize_serializers(std::vector<C> const& iSerializersPerLane) {
 
   std::chrono::microseconds serializerTime = std::chrono::microseconds::zero();
   
+  unsigned long long reallocations = 0;
+
   std::vector<std::pair<std::string_view, std::chrono::microseconds>> serializerTimes;
   serializerTimes.reserve( iSerializersPerLane[0].size());
+  std::vector<unsigned long long> serializerReallocations(iSerializersPerLane[0].size(), 0);
   bool isFirst = true;
   for(auto const& serializers: iSerializersPerLane) {
     if(isFirst) {
@@ -30,6 +33,17 @@ inline void summarize_serializers(std::vector<C> const& iSerializersPerLane) {
 	serializerTime += s.accumulatedTime();
       }
     }
+    int i = 0;
+    for(auto& s: serializers) {
+      serializerReallocations[i++] += s.bufferReallocations();
+      reallocations += s.bufferReallocations();
+    }
+  }
+  std::vector<std::pair<std::string_view, unsigned long long>> reallocationsPerProduct;
+  for(std::size_t i = 0; i < serializerReallocations.size(); ++i) {
+    if(serializerReallocations[i] != 0) {
+      reallocationsPerProduct.emplace_back(serializerTimes[i].first, serializerReallocations[i]);
+    }
   }
 
   std::sort(serializerTimes.begin(),serializerTimes.end(), [](auto const& iLHS, auto const& iRHS) {
@@ -41,6 +55,14 @@ inline void summarize_serializers(std::vector<C> const& iSerializersPerLane) {
   for(auto const& p: serializerTimes) {
     std::cout <<"time: "<<p.second.count()<<"us "<<std::setprecision(4)<<(100.*p.second.count()/serializerTime.count())<<"%\tname: "<<p.first<<"\n";
   }
+
+  std::sort(reallocationsPerProduct.begin(),reallocationsPerProduct.end(), [](auto const& iLHS, auto const& iRHS) {
+      return iLHS.second > iRHS.second;
+    });
+  std::cout <<"Serialization buffer reallocations: "<<reallocations<<"\n";
+  for(auto const& p: reallocationsPerProduct) {
+    std::cout <<"reallocations: "<<p.second<<"\tname: "<<p.first<<"\n";
+  }
 }
 }
 #endif
@@ -6,6 +6,11 @@
 #include <string>
 #include <memory>
 
+namespace cce::tf::specialized {
+  template<typename T>
+  struct Layout;
+}
+
 namespace cce::tf::test {
 
   class SimpleClass {
@@ -23,6 +28,8 @@ namespace cce::tf::test {
       return not operator==(iOther);
     }
 
+    template<typename T>
+    friend struct cce::tf::specialized::Layout;
   private:
     int m_int;
   };
@@ -50,6 +57,8 @@ namespace cce::tf::test {
     }
 
 
+    template<typename T>
+    friend struct cce::tf::specialized::Layout;
   private:
 
     std::string m_string;
@@ -107,6 +116,9 @@ namespace cce::tf::test {
     TestClassWithFloatVector(std::vector<float> iFloat): m_floats(std::move(iFloat)) {}
 
     std::vector<float> const& values() const {return m_floats;}
+
+    template<typename T>
+    friend struct cce::tf::specialized::Layout;
   private:
     std::vector<float> m_floats;
   };
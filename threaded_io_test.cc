@@ -14,6 +14,10 @@
 #include "sourceFactoryGenerator.h"
 
 #include "Lane.h"
+#include "UnrolledSerializer.h"
+#include "SerialTaskQueue.h"
+#include "TaskHolder.h"
+#include "LaneController.h"
 
 #include "tbb/task_group.h"
 #include "tbb/global_control.h"
@@ -57,8 +61,43 @@ int main(int argc, char* argv[]) {
   double scale = -1.;
   app.add_option("--scale", scale, "Scale to use when converting data product size to wait time. A value less than 1 turns off this feature. \nDefault is -1.");
 
+  unsigned int parallelThreshold = 0;
+  app.add_option("--parallel-collection-threshold", parallelThreshold, "Unrolled serializers split top level collections with more elements than this into chunks which are serialized concurrently. 0 turns this off.\nDefault is 0.");
+
+  unsigned int claimSize = 1;
+  app.add_option("--claim-size", claimSize, "Number of consecutive event indices a Lane claims at a time.\nDefault is 1.");
+
+  std::string serialQueue = SerialTaskQueue::defaultMode() == SerialTaskQueue::Mode::kCombining ? "combining" : "spawn";
+  app.add_option("--serial-queue", serialQueue, "How queued serial work is run, 'spawn' starts a new task for each item, 'combining' runs items back-to-back on the thread which finds the queue idle.\nDefault is "+serialQueue+".");
+
+  bool inlineContinuations = false;
+  app.add_option("--inline-continuations", inlineContinuations, "Run a task on the thread which finished the last work it was waiting for instead of scheduling it.\nDefault is false.");
+
+  bool adaptiveLanes = false;
+  app.add_option("--adaptive-lanes", adaptiveLanes, "Start with a few Lanes and adjust the number of active Lanes, up to the value of --num-lanes, from the measured event throughput and serial queue occupancy.\nDefault is false.");
+
   CLI11_PARSE(app, argc, argv);
 
+  SerialTaskQueue::setMeasureOccupancy(adaptiveLanes);
+
+  TaskHolder::setRunInline(inlineContinuations);
+
+  if(serialQueue == "spawn") {
+    SerialTaskQueue::setDefaultMode(SerialTaskQueue::Mode::kSpawn);
+  } else if(serialQueue == "combining") {
+    SerialTaskQueue::setDefaultMode(SerialTaskQueue::Mode::kCombining);
+  } else {
+    std::cout <<"unknown --serial-queue value "<<serialQueue<<std::endl;
+    return 1;
+  }
+
+  if(claimSize == 0) {
+    std::cout <<"--claim-size must be at least 1"<<std::endl;
+    return 1;
+  }
+
+  UnrolledSerializer::setParallelThreshold(parallelThreshold);
+
   tbb::global_control c(tbb::global_control::max_allowed_parallelism, parallelism);
 
   //Tell Root we want to be multi-threaded
@@ -126,6 +165,7 @@ int main(int argc, char* argv[]) {
   lanes.reserve(nLanes);
   for(unsigned int i = 0; i< nLanes; ++i) {
     lanes.emplace_back(i, source.get(), scale);
+    lanes.back().setClaimSize(claimSize);
     out->setupForLane(i, lanes.back().dataProducts());
   }
 
@@ -135,14 +175,31 @@ int main(int argc, char* argv[]) {
 
   decltype(std::chrono::high_resolution_clock::now()) start;
   auto pOut = out.get();
-  arena.execute([&lanes, &ievt, pOut, &start]() {
+  std::unique_ptr<LaneController> controller;
+  arena.execute([&lanes, &ievt, pOut, &start, &controller, adaptiveLanes, parallelism]() {
     std::atomic<unsigned int> nLanesWaiting{ 0 };
     std::vector<tbb::task_group> groups(lanes.size());
+    if(adaptiveLanes) {
+      //a few Lanes, the controller adds more if that helps
+      unsigned int startLanes = std::max(2, parallelism/4);
+      controller = std::make_unique<LaneController>(lanes.size(), startLanes, [&lanes, &ievt, &groups, &nLanesWaiting, pOut](unsigned int iLane) {
+          //the Lane calling the controller holds a count so nLanesWaiting is not 0
+          AtomicRefCounter laneCounter(nLanesWaiting);
+          auto pLane = &lanes[iLane];
+          auto pGroup = &groups[iLane];
+          pGroup->run([pLane, pGroup, &ievt, pOut, laneCounter]() {pLane->processEventsAsync(ievt, *pGroup, *pOut, laneCounter);});
+        });
+      for(auto& lane: lanes) {
+        lane.setController(controller.get());
+      }
+    }
     start = std::chrono::high_resolution_clock::now();
     auto itGroup = groups.begin();
     {
       AtomicRefCounter laneCounter(nLanesWaiting);
-      for(auto& lane: lanes) {
+      unsigned int nLanesToStart = controller ? controller->targetLanes() : lanes.size();
+      for(unsigned int i = 0; i < nLanesToStart; ++i) {
+        auto& lane = lanes[i];
         auto& group = *itGroup;
         group.run([&, laneCounter]() {lane.processEventsAsync(ievt,group, *pOut,laneCounter);});
         ++itGroup;
@@ -157,20 +214,46 @@ int main(int argc, char* argv[]) {
     for(auto& group: groups) {
       group.wait();
     }
+    if(controller) {
+      controller->finish();
+    }
   });
 
   std::chrono::microseconds eventTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now()-start);
 
-  //NOTE: each lane will go 1 beyond the # events so ievt is more then the # events
+  //NOTE: each lane claims beyond the # events so ievt is more then the # events
+  unsigned long long nEventsProcessed = 0;
+  unsigned long long nTaskAllocations = 0;
+  unsigned long long nTaskSlabAllocations = 0;
+  unsigned long long nTaskSlabReuses = 0;
+  unsigned long long nTasksTooLarge = 0;
+  for(auto const& lane: lanes) {
+    nEventsProcessed += lane.nEventsProcessed();
+    auto const& arena = lane.taskArena();
+    nTaskAllocations += arena.allocations();
+    nTaskSlabAllocations += arena.slabAllocations();
+    nTaskSlabReuses += arena.slabReuses();
+    nTasksTooLarge += arena.tooLarge();
+  }
   std::cout <<"----------"<<std::endl;
   std::cout <<"Source "<<sourceConfig<<"\n"
             <<"Outputer "<<outputerConfig<<"\n"
 	    <<"# threads "<<parallelism<<"\n"
 	    <<"# concurrent events "<<nLanes <<"\n"
+	    <<"event claim size "<<claimSize <<"\n"
+	    <<"serial queue "<<serialQueue <<"\n"
+	    <<"inline continuations "<<(inlineContinuations? "true\n":"false\n")
+	    <<"adaptive lanes "<<(adaptiveLanes? "true\n":"false\n")
 	    <<"time scale "<<scale<<"\n"
 	    <<"use ROOT IMT "<< (useIMT? "true\n":"false\n");
   std::cout <<"Event processing time: "<<eventTime.count()<<"us"<<std::endl;
-  std::cout <<"number events: "<<ievt.load() -nLanes<<std::endl;
+  std::cout <<"number events: "<<nEventsProcessed<<std::endl;
+  if(controller) {
+    std::cout <<"adaptive lanes steady state: "<<controller->steadyStateLanes()<<" final: "<<controller->targetLanes()
+              <<" adjustments: "<<controller->nAdjustments()<<std::endl;
+  }
+  std::cout <<"tasks made in lane arenas: "<<nTaskAllocations<<" slabs allocated: "<<nTaskSlabAllocations<<" slabs reused: "<<nTaskSlabReuses
+            <<" tasks too large: "<<nTasksTooLarge<<std::endl;
   std::cout <<"----------"<<std::endl;
 
   source->printSummary();
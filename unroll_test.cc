@@ -1,24 +1,22 @@
 #include "UnrolledSerializer.h"
 #include "UnrolledDeserializer.h"
 #include "Serializer.h"
+#include "SpecializedSerializer.h"
 
 #include "TClass.h"
 #include "TClonesArray.h"
+#include "TBufferFile.h"
 
 #include <iostream>
 #include <string>
 #include <memory>
 #include <vector>
+#include <algorithm>
+#include <functional>
 
 #include "cms/EventAuxiliary.h"
 #include "test_classes/TestClasses.h"
 
-namespace edm::detail {
-  static std::string const invalidHash;
-  std::string const& InvalidHash() { return invalidHash;}
-}
-
-
 namespace {
   template<typename T>
   T runTest(T const& iObject) {
@@ -35,7 +33,8 @@ namespace {
 
   UnrolledSerializer us(cls);
 
-  auto buffer = us.serialize(&iObject);
+  auto blob = us.serialize(&iObject);
+  std::vector<char> buffer(blob.begin(), blob.end());
 
   std::cout <<"unrolled size "<<buffer.size()<<std::endl;
 
@@ -48,11 +47,46 @@ namespace {
   UnrolledDeserializer ud(cls);
   
   T newObj;
-  ud.deserialize(buffer, &newObj);
+  ud.deserialize(0, buffer, &newObj);
 
   return newObj;
   }
 
+  //the specialized serializer must write the same bytes as the UnrolledSerializer and
+  // those bytes must read back to an equal object
+  template<typename T, typename C>
+  bool runSpecializedTest(T const& iObject, C iCompare) {
+    using namespace cce::tf;
+
+    auto cls = TClass::GetClass(typeid(T));
+    auto entry = specialized::find(*cls);
+    if(nullptr == entry) {
+      std::cout <<"NO SPECIALIZED SERIALIZER"<<std::endl;
+      return false;
+    }
+
+    UnrolledSerializer us(cls);
+    auto expected = us.serialize(&iObject);
+
+    TBufferFile buffer{TBuffer::kWrite};
+    entry->write_(buffer, cls, &iObject);
+    std::cout <<"specialized size "<<buffer.Length()<<" unrolled size "<<expected.size()<<std::endl;
+    if(not std::equal(expected.begin(), expected.end(), buffer.Buffer(), buffer.Buffer()+buffer.Length())) {
+      std::cout <<"ERROR: bytes differ from the UnrolledSerializer"<<std::endl;
+      return false;
+    }
+
+    std::vector<char> bytes(buffer.Buffer(), buffer.Buffer()+buffer.Length());
+    UnrolledDeserializer ud(cls);
+    T newObj;
+    ud.deserialize(0, bytes, &newObj);
+    if(not iCompare(iObject, newObj)) {
+      std::cout <<"ERROR: read back a different object"<<std::endl;
+      return false;
+    }
+    return true;
+  }
+
   void testNamedClass(const char* iName) {
     TClass* cls = TClass::GetClass(iName);
 
@@ -407,5 +441,49 @@ int runTestClasses() {
     }
   }
   
+  {
+    std::cout <<"**specialized edm::EventAuxiliary**"<<std::endl;
+    edm::EventAuxiliary ev({1,2,3}, "32981", edm::Timestamp{45}, true, edm::EventAuxiliary::PhysicsTrigger, 12, 13, 14);
+    auto same = [](edm::EventAuxiliary const& iLHS, edm::EventAuxiliary const& iRHS) {
+      return iLHS.id() == iRHS.id() and iLHS.processGUID() == iRHS.processGUID() and iLHS.time() == iRHS.time() and
+        iLHS.isRealData() == iRHS.isRealData() and iLHS.experimentType() == iRHS.experimentType() and
+        iLHS.bunchCrossing() == iRHS.bunchCrossing() and iLHS.storeNumber() == iRHS.storeNumber() and iLHS.orbitNumber() == iRHS.orbitNumber();
+    };
+    if(not runSpecializedTest(ev, same)) {
+      return 1;
+    }
+  }
+
+  {
+    std::cout <<"**specialized SimpleClass**"<<std::endl;
+    if(not runSpecializedTest(cce::tf::test::SimpleClass(5), std::equal_to<>())) {
+      return 1;
+    }
+  }
+
+  {
+    std::cout <<"**specialized TestClass**"<<std::endl;
+    if(not runSpecializedTest(cce::tf::test::TestClass("foo", 78.9), std::equal_to<>())) {
+      return 1;
+    }
+  }
+
+  {
+    std::cout <<"**specialized TestClassWithFloatVector**"<<std::endl;
+    auto same = [](cce::tf::test::TestClassWithFloatVector const& iLHS, cce::tf::test::TestClassWithFloatVector const& iRHS) {
+      return compare_containers(iLHS.values(), iRHS.values());
+    };
+    if(not runSpecializedTest(cce::tf::test::TestClassWithFloatVector({1,2,3,5}), same)) {
+      return 1;
+    }
+  }
+
+  {
+    std::cout <<"**specialized std::vector<double>**"<<std::endl;
+    if(not runSpecializedTest(std::vector<double>({1.5, 2.5, 3.5}), std::equal_to<>())) {
+      return 1;
+    }
+  }
+
   return 0;
 }